@@ -0,0 +1,1149 @@
+// timing harness for the rendering and loading paths
+// run from the Engine directory (assets are loaded from Images\)
+//	ChiliBench [section...]    (no sections runs all of them)
+#include "Graphics.h"
+#include "BlitKernels.h"
+#include "MemoryFrameTarget.h"
+#include "RenderQueue.h"
+#include "SpriteEffect.h"
+#include "Surface.h"
+#include "SurfaceAtlas.h"
+#include "FrameTimer.h"
+#include "ImageFile.h"
+#include "Codex.h"
+#include "FilePath.h"
+#include "Poo.h"
+#include "Bullet.h"
+#include "SpatialGrid.h"
+#include "World.h"
+#include "Background.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// best of reps runs of f, in seconds (best rather than mean, so a preempted run
+	// doesn't skew the result)
+	double Time( int reps,const std::function<void()>& f )
+	{
+		FrameTimer ft;
+		double best = 1e9;
+		for( int i = 0; i < reps; i++ )
+		{
+			ft.Mark();
+			f();
+			best = std::min( best,double( ft.Mark() ) );
+		}
+		return best;
+	}
+
+	std::unique_ptr<Graphics> MakeGraphics()
+	{
+		auto pGfx = std::make_unique<Graphics>( std::make_unique<MemoryFrameTarget>() );
+		pGfx->BeginFrame();
+		return pGfx;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// spans: row span effects against the per-pixel effect callbacks they replaced
+
+	// the effects as they were before DrawSprite handed out spans, one call per pixel
+	// going through Graphics::PutPixel / GetPixel
+	namespace PerPixel
+	{
+		class Chroma
+		{
+		public:
+			Chroma( Color c )
+				:
+				chroma( c )
+			{}
+			void operator()( Color cSrc,int xDest,int yDest,Graphics& gfx ) const
+			{
+				if( cSrc != chroma )
+				{
+					gfx.PutPixel( xDest,yDest,cSrc );
+				}
+			}
+		private:
+			Color chroma;
+		};
+		class Substitution
+		{
+		public:
+			Substitution( Color c,Color s )
+				:
+				chroma( c ),
+				sub( s )
+			{}
+			void operator()( Color cSrc,int xDest,int yDest,Graphics& gfx ) const
+			{
+				if( cSrc != chroma )
+				{
+					gfx.PutPixel( xDest,yDest,sub );
+				}
+			}
+		private:
+			Color chroma;
+			Color sub;
+		};
+		class Copy
+		{
+		public:
+			void operator()( Color cSrc,int xDest,int yDest,Graphics& gfx ) const
+			{
+				gfx.PutPixel( xDest,yDest,cSrc );
+			}
+		};
+		class Ghost
+		{
+		public:
+			Ghost( Color c )
+				:
+				chroma( c )
+			{}
+			void operator()( Color src,int xDest,int yDest,Graphics& gfx ) const
+			{
+				if( src != chroma )
+				{
+					const Color dest = gfx.GetPixel( xDest,yDest );
+					const Color blend = {
+						(unsigned char)((src.GetR() + dest.GetR()) / 2),
+						(unsigned char)((src.GetG() + dest.GetG()) / 2),
+						(unsigned char)((src.GetB() + dest.GetB()) / 2)
+					};
+					gfx.PutPixel( xDest,yDest,blend );
+				}
+			}
+		private:
+			Color chroma;
+		};
+		class DissolveHalfTint
+		{
+		public:
+			DissolveHalfTint( Color chroma,Color tint,float percent )
+				:
+				chroma( chroma ),
+				tint_pre( (tint.dword >> 1u) & 0b01111111011111110111111101111111u ),
+				filled( int( float( height ) * percent ) )
+			{}
+			void operator()( Color src,int xDest,int yDest,Graphics& gfx ) const
+			{
+				if( src != chroma && (yDest & height_mask) < filled )
+				{
+					const Color blend = tint_pre.dword +
+						((src.dword >> 1u) & 0b01111111011111110111111101111111u);
+					gfx.PutPixel( xDest,yDest,blend );
+				}
+			}
+		private:
+			Color chroma;
+			Color tint_pre;
+			static constexpr int height = 4;
+			static constexpr int height_mask = height - 1;
+			int filled;
+		};
+		class AlphaBlendBaked
+		{
+		public:
+			void operator()( Color src,int xDest,int yDest,Graphics& gfx ) const
+			{
+				const int cAlpha = 255 - src.GetA();
+				if( cAlpha != 255 )
+				{
+					const Color dst = gfx.GetPixel( xDest,yDest );
+					const int rb = (((dst.dword & 0xFF00FFu) * cAlpha) >> 8) & 0xFF00FFu;
+					const int g = (((dst.dword & 0x00FF00u) * cAlpha) >> 8) & 0x00FF00u;
+					gfx.PutPixel( xDest,yDest,rb + g + src.dword );
+				}
+			}
+		};
+
+		// the old DrawSprite loop (sprites here are always fully on screen)
+		template<typename E>
+		void DrawSprite( Graphics& gfx,int x,int y,const RectI& srcRect,const Surface& s,E effect )
+		{
+			for( int sy = srcRect.top; sy < srcRect.bottom; sy++ )
+			{
+				for( int sx = srcRect.left; sx < srcRect.right; sx++ )
+				{
+					effect( s.GetPixel( sx,sy ),x + sx - srcRect.left,y + sy - srcRect.top,gfx );
+				}
+			}
+		}
+	}
+
+	// draws every 90x90 frame of the link sheet once, tiled over the screen
+	template<typename Draw>
+	int DrawLinkFrames( const Surface& link,Draw draw )
+	{
+		int nPixels = 0;
+		for( int fy = 0; fy < link.GetHeight() / 90; fy++ )
+		{
+			for( int fx = 0; fx < link.GetWidth() / 90; fx++ )
+			{
+				const int i = fy * (link.GetWidth() / 90) + fx;
+				draw( (i % 8) * 95 + 20,(i / 8) * 95 + 20,RectI{ fx * 90,fx * 90 + 90,fy * 90,fy * 90 + 90 } );
+				nPixels += 90 * 90;
+			}
+		}
+		return nPixels;
+	}
+
+	template<typename OldE,typename NewE>
+	void CompareSpans( Graphics& gfx,const char* name,const Surface& s,bool sheet,OldE oldEffect,NewE newEffect )
+	{
+		int nPixels = 0;
+		const double tOld = Time( 20,[&]()
+		{
+			nPixels = sheet ?
+				DrawLinkFrames( s,[&]( int x,int y,const RectI& r ) { PerPixel::DrawSprite( gfx,x,y,r,s,oldEffect ); } ) :
+				(PerPixel::DrawSprite( gfx,0,0,s.GetRect(),s,oldEffect ),s.GetWidth() * s.GetHeight());
+		} );
+		const double tNew = Time( 20,[&]()
+		{
+			if( sheet )
+			{
+				DrawLinkFrames( s,[&]( int x,int y,const RectI& r ) { gfx.DrawSprite( x,y,r,s,newEffect ); } );
+			}
+			else
+			{
+				gfx.DrawSprite( 0,0,s,newEffect );
+			}
+		} );
+		std::printf( "  %-18s per pixel %8.1f Mpx/s   spans %8.1f Mpx/s   x%.1f\n",name,
+			nPixels / tOld * 1e-6,nPixels / tNew * 1e-6,tOld / tNew );
+	}
+
+	void BenchSpans()
+	{
+		std::printf( "spans: DrawSprite source pixels per second, per pixel effects vs row spans\n" );
+		auto pGfx = MakeGraphics();
+		Graphics& gfx = *pGfx;
+		const Surface link( L"Images\\link90x90.bmp" );
+		const Surface dice( L"Images\\pm_alphadice.png" );
+		CompareSpans( gfx,"Chroma",link,true,PerPixel::Chroma{ Colors::Magenta },SpriteEffect::Chroma{ Colors::Magenta } );
+		CompareSpans( gfx,"Substitution",link,true,PerPixel::Substitution{ Colors::Magenta,Colors::White },
+			SpriteEffect::Substitution{ Colors::Magenta,Colors::White } );
+		CompareSpans( gfx,"Copy",link,true,PerPixel::Copy{},SpriteEffect::Copy{} );
+		CompareSpans( gfx,"Ghost",link,true,PerPixel::Ghost{ Colors::Magenta },SpriteEffect::Ghost{ Colors::Magenta } );
+		CompareSpans( gfx,"DissolveHalfTint",link,true,PerPixel::DissolveHalfTint{ Colors::Magenta,Colors::Red,0.5f },
+			SpriteEffect::DissolveHalfTint{ Colors::Magenta,Colors::Red,0.5f } );
+		CompareSpans( gfx,"AlphaBlendBaked",dice,false,PerPixel::AlphaBlendBaked{},SpriteEffect::AlphaBlendBaked{} );
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// surfaces: copying and moving surfaces around
+
+	// what copying a surface cost before the bulk row copies
+	Surface PerPixelCopy( const Surface& src )
+	{
+		Surface dst( src.GetWidth(),src.GetHeight() );
+		for( int y = 0; y < src.GetHeight(); y++ )
+		{
+			for( int x = 0; x < src.GetWidth(); x++ )
+			{
+				dst.PutPixel( x,y,src.GetPixel( x,y ) );
+			}
+		}
+		return dst;
+	}
+
+	// a surface that can only be copied (what containers had to do before moves)
+	class CopyOnlySurface
+	{
+	public:
+		CopyOnlySurface( int width,int height )
+			:
+			s( width,height )
+		{}
+		CopyOnlySurface( const CopyOnlySurface& src )
+			:
+			s( src.s )
+		{}
+		CopyOnlySurface& operator=( const CopyOnlySurface& src )
+		{
+			s = src.s;
+			return *this;
+		}
+	private:
+		Surface s;
+	};
+
+	template<typename S>
+	double GrowVector( int count,int width,int height )
+	{
+		return Time( 10,[=]()
+		{
+			std::vector<S> v;
+			for( int i = 0; i < count; i++ )
+			{
+				v.emplace_back( width,height );
+			}
+		} );
+	}
+
+	void BenchSurfaces()
+	{
+		std::printf( "surfaces: copying and moving an 800x600 surface\n" );
+		const Surface src( L"Images\\pm_alphadice.png" );
+		const double tPerPixel = Time( 20,[&]() { Surface s = PerPixelCopy( src ); } );
+		const double tCopy = Time( 20,[&]() { Surface s = src; } );
+		Surface a = src;
+		const double tMove = Time( 20,[&]() { Surface b = std::move( a ); a = std::move( b ); } ) / 2.0;
+		std::printf( "  copy, per pixel   %9.3f ms\n",tPerPixel * 1e3 );
+		std::printf( "  copy, bulk        %9.3f ms   x%.0f\n",tCopy * 1e3,tPerPixel / tCopy );
+		std::printf( "  move              %9.3f us\n",tMove * 1e6 );
+		std::printf( "  vector of 256 128x128 surfaces, growing from empty\n" );
+		const double tCopyGrow = GrowVector<CopyOnlySurface>( 256,128,128 );
+		const double tMoveGrow = GrowVector<Surface>( 256,128,128 );
+		std::printf( "    copy only       %9.3f ms\n",tCopyGrow * 1e3 );
+		std::printf( "    Surface         %9.3f ms   x%.1f\n",tMoveGrow * 1e3,tCopyGrow / tMoveGrow );
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// decode: ImageFile::Load on every image the game ships
+
+	void BenchDecode()
+	{
+		std::printf( "decode: ImageFile::Load, best of 10\n" );
+		const wchar_t* const files[] = {
+			L"Images\\Fixedsys16x28.bmp",
+			L"Images\\chilihead.bmp",
+			L"Images\\fireball.bmp",
+			L"Images\\floor5.bmp",
+			L"Images\\legs-skinny.bmp",
+			L"Images\\link90x90.bmp",
+			L"Images\\poo.bmp",
+			L"Images\\pm_alphadice.png"
+		};
+		for( const auto f : files )
+		{
+			int nPixels = 0;
+			const double t = Time( 10,[&]()
+			{
+				const Surface s = ImageFile::Load( f );
+				nPixels = s.GetWidth() * s.GetHeight();
+			} );
+			std::printf( "  %-28ls %8d px %8.3f ms %8.1f Mpx/s\n",f,nPixels,t * 1e3,nPixels / t * 1e-6 );
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// cache: every shipped image through Codex<Surface> with no .surf files (decode and
+	// write the cache), then again with the caches in place (map them)
+	// every pixel is read once after loading, so the mapped pages actually get faulted in
+
+	void BenchCache()
+	{
+		std::printf( "cache: load all images through Codex and read them, best of 5\n" );
+		const wchar_t* const files[] = {
+			L"Images\\Fixedsys16x28.bmp",
+			L"Images\\chilihead.bmp",
+			L"Images\\fireball.bmp",
+			L"Images\\floor5.bmp",
+			L"Images\\legs-skinny.bmp",
+			L"Images\\link90x90.bmp",
+			L"Images\\poo.bmp",
+			L"Images\\pm_alphadice.png"
+		};
+		unsigned int sum = 0u;
+		const auto loadAll = [&]()
+		{
+			for( const auto f : files )
+			{
+				const Surface& s = *Codex<Surface>::Retrieve( f );
+				for( int y = 0; y < s.GetHeight(); y++ )
+				{
+					for( int x = 0; x < s.GetWidth(); x++ )
+					{
+						sum += s.GetPixel( x,y ).dword;
+					}
+				}
+			}
+		};
+		FrameTimer ft;
+		double cold = 1e9;
+		double warm = 1e9;
+		for( int rep = 0; rep < 5; rep++ )
+		{
+			for( const auto f : files )
+			{
+				std::remove( ToNarrowPath( std::wstring( f ) + L".surf" ).c_str() );
+			}
+			Codex<Surface>::Purge();
+			ft.Mark();
+			loadAll();
+			cold = std::min( cold,double( ft.Mark() ) );
+			Codex<Surface>::Purge();
+			ft.Mark();
+			loadAll();
+			warm = std::min( warm,double( ft.Mark() ) );
+		}
+		Codex<Surface>::Purge();
+		std::printf( "  cold (decode + write) %8.3f ms\n",cold * 1e3 );
+		std::printf( "  warm (map)            %8.3f ms   %.1fx   (checksum %08x)\n",warm * 1e3,cold / warm,sum );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// pipelines: effects built from stages against the hand-written span loops they replaced
+
+// outside the anonymous namespace, so DrawSprite<HandWritten::...> gets the same linkage as
+// DrawSprite<SpriteEffect::...> (with internal linkage gcc clones it with the effect's colors
+// folded in as constants, which the effects in the game never get)
+namespace HandWritten
+{
+	class Substitution
+	{
+	public:
+		Substitution( Color c,Color s )
+			:
+			chroma( c ),
+			sub( s )
+		{}
+		void operator()( const Color* pSrc,int srcStep,Color* pDst,int n,int /*yDest*/ ) const
+		{
+			for( int i = 0; i < n; i++,pSrc += srcStep )
+			{
+				if( *pSrc != chroma )
+				{
+					pDst[i] = sub;
+				}
+			}
+		}
+	private:
+		Color chroma;
+		Color sub;
+	};
+	class Fill
+	{
+	public:
+		Fill( Color c )
+			:
+			color( c )
+		{}
+		void operator()( const Color* /*pSrc*/,int /*srcStep*/,Color* pDst,int n,int /*yDest*/ ) const
+		{
+			std::fill( pDst,pDst + n,color );
+		}
+	private:
+		Color color;
+	};
+	class Ghost
+	{
+	public:
+		Ghost( Color c )
+			:
+			chroma( c )
+		{}
+		void operator()( const Color* pSrc,int srcStep,Color* pDst,int n,int /*yDest*/ ) const
+		{
+			for( int i = 0; i < n; i++,pSrc += srcStep )
+			{
+				const Color src = *pSrc;
+				if( src != chroma )
+				{
+					const Color dest = pDst[i];
+					const Color blend = {
+						(unsigned char)((src.GetR() + dest.GetR()) / 2),
+						(unsigned char)((src.GetG() + dest.GetG()) / 2),
+						(unsigned char)((src.GetB() + dest.GetB()) / 2)
+					};
+					pDst[i] = blend;
+				}
+			}
+		}
+	private:
+		Color chroma;
+	};
+	class DissolveHalfTint
+	{
+	public:
+		DissolveHalfTint( Color chroma,Color tint,float percent )
+			:
+			chroma( chroma ),
+			tint_pre( (tint.dword >> 1u) & 0b01111111011111110111111101111111u ),
+			filled( int( float( height ) * percent ) )
+		{}
+		void operator()( const Color* pSrc,int srcStep,Color* pDst,int n,int yDest ) const
+		{
+			if( (yDest & height_mask) >= filled )
+			{
+				return;
+			}
+			for( int i = 0; i < n; i++,pSrc += srcStep )
+			{
+				const Color src = *pSrc;
+				if( src != chroma )
+				{
+					pDst[i] = tint_pre.dword +
+						((src.dword >> 1u) & 0b01111111011111110111111101111111u);
+				}
+			}
+		}
+	private:
+		Color chroma;
+		Color tint_pre;
+		static constexpr int height = 4;
+		static constexpr int height_mask = height - 1;
+		int filled;
+	};
+}
+
+namespace
+{
+	template<typename OldE,typename NewE>
+	void ComparePipeline( Graphics& gfx,const char* name,const Surface& link,OldE oldEffect,NewE newEffect )
+	{
+		// a few passes per run so a run is long enough to time reliably
+		int nPixels = 0;
+		const auto draw = [&]( auto effect )
+		{
+			for( int pass = 0; pass < 8; pass++ )
+			{
+				nPixels = 8 * DrawLinkFrames( link,[&]( int x,int y,const RectI& r ) { gfx.DrawSprite( x,y,r,link,effect ); } );
+			}
+		};
+		// alternate the two so neither always runs on a warmer cache / clock
+		double tOld = 1e9;
+		double tNew = 1e9;
+		for( int i = 0; i < 30; i++ )
+		{
+			tOld = std::min( tOld,Time( 1,[&]() { draw( oldEffect ); } ) );
+			tNew = std::min( tNew,Time( 1,[&]() { draw( newEffect ); } ) );
+		}
+		std::printf( "  %-18s hand-written %8.1f Mpx/s   pipeline %8.1f Mpx/s   %+.1f%%\n",name,
+			nPixels / tOld * 1e-6,nPixels / tNew * 1e-6,(tNew / tOld - 1.0) * 100.0 );
+	}
+
+	void BenchPipelines()
+	{
+		std::printf( "pipelines: DrawSprite source pixels per second, hand-written span loops vs stage pipelines\n" );
+		auto pGfx = MakeGraphics();
+		Graphics& gfx = *pGfx;
+		const Surface link( L"Images\\link90x90.bmp" );
+		ComparePipeline( gfx,"Substitution",link,HandWritten::Substitution{ Colors::Magenta,Colors::White },
+			SpriteEffect::Substitution{ Colors::Magenta,Colors::White } );
+		ComparePipeline( gfx,"Fill",link,HandWritten::Fill{ Colors::White },SpriteEffect::Fill{ Colors::White } );
+		ComparePipeline( gfx,"Ghost",link,HandWritten::Ghost{ Colors::Magenta },SpriteEffect::Ghost{ Colors::Magenta } );
+		ComparePipeline( gfx,"DissolveHalfTint",link,HandWritten::DissolveHalfTint{ Colors::Magenta,Colors::Red,0.5f },
+			SpriteEffect::DissolveHalfTint{ Colors::Magenta,Colors::Red,0.5f } );
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// bands: RenderQueue playback split into bands against drawing straight into Graphics
+	// (800x600 only: the screen size is a compile time constant all through Graphics and
+	// the game, so scaling at larger framebuffers is not measured)
+
+	// a busy frame: the baked alpha dice over the whole screen, then 300 link frames
+	// scattered around (chroma keyed, every 4th one ghosted)
+	template<typename Target>
+	void DrawScene( Target& target,const Surface& dice,const Surface& link )
+	{
+		target.DrawSprite( 0,0,dice,SpriteEffect::AlphaBlendBaked{} );
+		unsigned int seed = 12345u;
+		for( int i = 0; i < 300; i++ )
+		{
+			seed = seed * 1664525u + 1013904223u;
+			const int x = int( (seed >> 8) % (Graphics::ScreenWidth - 90) );
+			const int y = int( (seed >> 20) % (Graphics::ScreenHeight - 90) );
+			const int fx = i % 5;
+			const int fy = (i / 5) % 4;
+			const RectI src = { fx * 90,fx * 90 + 90,fy * 90,fy * 90 + 90 };
+			if( i % 4 == 0 )
+			{
+				target.DrawSprite( x,y,src,link,SpriteEffect::Ghost{ Colors::Magenta } );
+			}
+			else
+			{
+				target.DrawSprite( x,y,src,link,SpriteEffect::Chroma{ Colors::Magenta } );
+			}
+		}
+	}
+
+	void BenchBands()
+	{
+		std::printf( "bands: %dx%d frame (full screen alpha blend + 300 sprites), %u hardware threads\n",
+			Graphics::ScreenWidth,Graphics::ScreenHeight,std::thread::hardware_concurrency() );
+		auto pGfx = MakeGraphics();
+		Graphics& gfx = *pGfx;
+		const Surface dice( L"Images\\pm_alphadice.png" );
+		const Surface link( L"Images\\link90x90.bmp" );
+		const double tDirect = Time( 30,[&]() { DrawScene( gfx,dice,link ); } );
+		std::printf( "  direct              %7.3f ms\n",tDirect * 1e3 );
+		for( int nBands : { 1,2,4,8 } )
+		{
+			RenderQueue rq( nBands );
+			const double t = Time( 30,[&]()
+			{
+				DrawScene( rq,dice,link );
+				rq.Render( gfx );
+			} );
+			const double tEmpty = Time( 200,[&]() { rq.Render( gfx ); } );
+			std::printf( "  queue, %d band(s)    %7.3f ms   x%.2f   (empty frame hand-off %6.1f us)\n",
+				nBands,t * 1e3,tDirect / t,tEmpty * 1e6 );
+		}
+		// what the workers would cost if they were started for each frame instead of kept
+		for( int nThreads : { 1,3,7 } )
+		{
+			const double t = Time( 200,[=]()
+			{
+				std::vector<std::thread> threads;
+				for( int i = 0; i < nThreads; i++ )
+				{
+					threads.emplace_back( [](){} );
+				}
+				for( auto& th : threads )
+				{
+					th.join();
+				}
+			} );
+			std::printf( "  spawn + join %d thread(s) per frame   %6.1f us\n",nThreads,t * 1e6 );
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// atlas: page use of the atlas, and a frame sampling every sprite sheet drawn from
+	// the atlas pages against the same sheets loaded as separate heap surfaces
+
+	void PrintAtlas( const char* name,const SurfaceAtlas& atlas )
+	{
+		std::printf( "  %-22s %d page(s) %8zu bytes %5.1f%% occupied\n",name,
+			atlas.GetPageCount(),atlas.GetPageBytes(),atlas.GetOccupancy() * 100.0f );
+	}
+
+	// last level cache misses of the calling thread (hardware counter, linux only)
+	// Available() is false where there is no such counter (most vms), the counts are then 0
+	class CacheMissCounter
+	{
+	public:
+		CacheMissCounter()
+		{
+#ifdef __linux__
+			perf_event_attr attr = {};
+			attr.size = sizeof( attr );
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			attr.disabled = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			fd = int( syscall( SYS_perf_event_open,&attr,0,-1,-1,0 ) );
+#endif
+		}
+		CacheMissCounter( const CacheMissCounter& ) = delete;
+		CacheMissCounter& operator=( const CacheMissCounter& ) = delete;
+		~CacheMissCounter()
+		{
+#ifdef __linux__
+			if( fd >= 0 )
+			{
+				close( fd );
+			}
+#endif
+		}
+		bool Available() const
+		{
+			return fd >= 0;
+		}
+		// misses while running f
+		long long Count( const std::function<void()>& f )
+		{
+			if( !Available() )
+			{
+				f();
+				return 0;
+			}
+			long long count = 0;
+#ifdef __linux__
+			ioctl( fd,PERF_EVENT_IOC_RESET,0 );
+			ioctl( fd,PERF_EVENT_IOC_ENABLE,0 );
+			f();
+			ioctl( fd,PERF_EVENT_IOC_DISABLE,0 );
+			if( read( fd,&count,sizeof( count ) ) != sizeof( count ) )
+			{
+				count = 0;
+			}
+#endif
+			return count;
+		}
+	private:
+		int fd = -1;
+	};
+
+	// one source rectangle of one sheet drawn somewhere on the screen
+	class SheetDraw
+	{
+	public:
+		int sheet;
+		RectI src;
+		int x;
+		int y;
+	};
+
+	// a frame of the game's sheets as World draws them: a screen of random floor tiles
+	// with poos, fireballs, legs and heads scattered over it
+	std::vector<SheetDraw> MakeSheetFrame()
+	{
+		std::vector<SheetDraw> draws;
+		std::mt19937 rng( 777u );
+		for( int y = 0; y + 32 <= Graphics::ScreenHeight; y += 32 )
+		{
+			for( int x = 0; x + 32 <= Graphics::ScreenWidth; x += 32 )
+			{
+				const int tile = int( rng() % 11u );
+				draws.push_back( { 0,{ tile * 32,tile * 32 + 32,0,32 },x,y } );
+			}
+		}
+		std::uniform_int_distribution<int> xDist( 0,Graphics::ScreenWidth - 64 );
+		std::uniform_int_distribution<int> yDist( 0,Graphics::ScreenHeight - 64 );
+		for( int i = 0; i < 60; i++ )
+		{
+			draws.push_back( { 1,{ 0,24,0,24 },xDist( rng ),yDist( rng ) } );
+			const int ball = int( rng() % 4u );
+			draws.push_back( { 2,{ ball * 8,ball * 8 + 8,0,8 },xDist( rng ),yDist( rng ) } );
+		}
+		for( int i = 0; i < 8; i++ )
+		{
+			const int leg = int( rng() % 10u );
+			draws.push_back( { 3,{ leg * 32,leg * 32 + 32,0,33 },xDist( rng ),yDist( rng ) } );
+			draws.push_back( { 4,{ 0,41,0,55 },xDist( rng ),yDist( rng ) } );
+		}
+		return draws;
+	}
+
+	void DrawSheetFrame( Graphics& gfx,const std::vector<SheetDraw>& draws,const Surface* const* sheets )
+	{
+		for( const auto& d : draws )
+		{
+			gfx.DrawSprite( d.x,d.y,d.src,*sheets[d.sheet],SpriteEffect::Chroma{ Colors::Magenta } );
+		}
+	}
+
+	// distinct 64 byte lines and 4k pages the source rows of a frame read
+	// (what the cache and tlb have to hold, whether or not a counter is available)
+	void SourceFootprint( const std::vector<SheetDraw>& draws,const Surface* const* sheets,size_t& lines,size_t& pages )
+	{
+		std::vector<uintptr_t> lineIds;
+		for( const auto& d : draws )
+		{
+			const Surface& s = *sheets[d.sheet];
+			for( int y = d.src.top; y < d.src.bottom; y++ )
+			{
+				const uintptr_t first = reinterpret_cast<uintptr_t>( s.GetRowPtr( y ) + d.src.left ) >> 6;
+				const uintptr_t last = reinterpret_cast<uintptr_t>( s.GetRowPtr( y ) + d.src.right - 1 ) >> 6;
+				for( uintptr_t l = first; l <= last; l++ )
+				{
+					lineIds.push_back( l );
+				}
+			}
+		}
+		std::sort( lineIds.begin(),lineIds.end() );
+		lineIds.erase( std::unique( lineIds.begin(),lineIds.end() ),lineIds.end() );
+		lines = lineIds.size();
+		for( auto& l : lineIds )
+		{
+			l >>= 6;
+		}
+		lineIds.erase( std::unique( lineIds.begin(),lineIds.end() ),lineIds.end() );
+		pages = lineIds.size();
+	}
+
+	void BenchAtlas()
+	{
+		std::printf( "atlas: page use, then a frame sampling every game sheet from the heap and from the atlas\n" );
+		const std::vector<std::wstring> sheetFiles = {
+			L"Images\\floor5.bmp",
+			L"Images\\poo.bmp",
+			L"Images\\fireball.bmp",
+			L"Images\\legs-skinny.bmp",
+			L"Images\\chilihead.bmp"
+		};
+		auto pGfx = MakeGraphics();
+		Graphics& gfx = *pGfx;
+		// heap surfaces first, each its own block (like before the atlas)
+		std::vector<Surface> heap;
+		for( const auto& f : sheetFiles )
+		{
+			heap.emplace_back( f );
+		}
+		const SurfaceAtlas every( sheetFiles );
+		// (the same sheets Game puts in its atlas)
+		PrintAtlas( "every game sheet",every );
+		const Surface* heapSheets[5];
+		const Surface* pagedSheets[5];
+		for( int i = 0; i < 5; i++ )
+		{
+			heapSheets[i] = &heap[i];
+			pagedSheets[i] = Codex<Surface>::Retrieve( sheetFiles[i] );
+		}
+		const std::vector<SheetDraw> draws = MakeSheetFrame();
+		CacheMissCounter misses;
+		double tHeap = 1e9;
+		double tPaged = 1e9;
+		long long missHeap = 0;
+		long long missPaged = 0;
+		for( int i = 0; i < 5; i++ )
+		{
+			tHeap = std::min( tHeap,Time( 200,[&]() { DrawSheetFrame( gfx,draws,heapSheets ); } ) );
+			tPaged = std::min( tPaged,Time( 200,[&]() { DrawSheetFrame( gfx,draws,pagedSheets ); } ) );
+		}
+		for( int i = 0; i < 200; i++ )
+		{
+			missHeap += misses.Count( [&]() { DrawSheetFrame( gfx,draws,heapSheets ); } );
+			missPaged += misses.Count( [&]() { DrawSheetFrame( gfx,draws,pagedSheets ); } );
+		}
+		const auto print = [&]( const char* name,double t,long long miss,const Surface* const* sheets )
+		{
+			size_t lines = 0;
+			size_t pages = 0;
+			SourceFootprint( draws,sheets,lines,pages );
+			std::printf( "  %-6s %7.1f us per frame   source %5zu lines %3zu pages   ",name,t * 1e6,lines,pages );
+			if( misses.Available() )
+			{
+				std::printf( "%8.1f cache misses per frame\n",double( miss ) / 200.0 );
+			}
+			else
+			{
+				std::printf( "cache misses n/a (no hardware counter)\n" );
+			}
+		};
+		print( "heap",tHeap,missHeap,heapSheets );
+		print( "atlas",tPaged,missPaged,pagedSheets );
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// stream: plain Copy against StreamCopy (streaming stores, used for the present upload)
+	// this is ordinary cached memory, the write-combined texture the present copies into
+	// only exists on windows, so these numbers are the cached side of the trade only
+
+	// touches one pixel per cache line, like whatever draws over or presents the span next
+	unsigned int ReadBack( const Color* p,int n )
+	{
+		unsigned int sum = 0u;
+		for( int i = 0; i < n; i += 16 )
+		{
+			sum += p[i].dword;
+		}
+		return sum;
+	}
+
+	void BenchStream()
+	{
+		std::printf( "stream: GB/s written, best of enough runs to move 64 MiB\n" );
+		std::printf( "  %9s %9s %11s %9s\n","pixels","Copy","StreamCopy","Fill" );
+		const int maxPixels = 1 << 24;
+		std::vector<Color> src( maxPixels,Colors::Blue );
+		std::vector<Color> dst( maxPixels,Colors::Red );
+		for( int n = 256; n <= maxPixels; n *= 4 )
+		{
+			const int reps = std::max( 5,(64 << 20) / int( sizeof( Color ) * n ) );
+			const double gb = double( sizeof( Color ) * n ) * 1e-9;
+			const double tCopy = Time( reps,[&]() { BlitKernels::Copy( src.data(),1,dst.data(),n ); } );
+			const double tStream = Time( reps,[&]() { BlitKernels::StreamCopy( src.data(),dst.data(),n ); } );
+			const double tFill = Time( reps,[&]() { BlitKernels::Fill( dst.data(),n,Colors::Green ); } );
+			std::printf( "  %9d %9.1f %11.1f %9.1f\n",n,gb / tCopy,gb / tStream,gb / tFill );
+		}
+		// what a frame actually does: copy the whole 800x600 frame row by row, then
+		// read it back (as drawing over it does)
+		constexpr int w = Graphics::ScreenWidth;
+		constexpr int h = Graphics::ScreenHeight;
+		volatile unsigned int sink = 0u;
+		const double tRows = Time( 100,[&]()
+		{
+			for( int y = 0; y < h; y++ )
+			{
+				BlitKernels::Copy( src.data() + y * w,1,dst.data() + y * w,w );
+			}
+			sink = ReadBack( dst.data(),w * h );
+		} );
+		const double tStreamRows = Time( 100,[&]()
+		{
+			for( int y = 0; y < h; y++ )
+			{
+				BlitKernels::StreamCopy( src.data() + y * w,dst.data() + y * w,w );
+			}
+			sink = ReadBack( dst.data(),w * h );
+		} );
+		std::printf( "  frame rows + read back: Copy %7.1f us   StreamCopy %7.1f us\n",tRows * 1e6,tStreamRows * 1e6 );
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// upload: whole frames on the memory target, drawn into the sysbuffer and stream copied
+	// into an upload buffer on present (what D3DFrameTarget does by default) against drawn
+	// straight into the upload buffer (Direct, D3DFrameTarget with -upload=direct)
+
+	void BenchUpload()
+	{
+		std::printf( "upload: clear, 60 chroma keyed link frames, present (best of 7 runs of 200 frames)\n" );
+		const Surface link( L"Images\\link90x90.bmp" );
+		const std::pair<const char*,MemoryFrameTarget::Upload> modes[] = {
+			{ "None",MemoryFrameTarget::Upload::None },
+			{ "Copy",MemoryFrameTarget::Upload::Copy },
+			{ "Direct",MemoryFrameTarget::Upload::Direct }
+		};
+		for( const auto& mode : modes )
+		{
+			Graphics gfx( std::make_unique<MemoryFrameTarget>( nullptr,mode.second ) );
+			const double t = Time( 7,[&]()
+			{
+				for( int frame = 0; frame < 200; frame++ )
+				{
+					gfx.BeginFrame();
+					for( int i = 0; i < 60; i++ )
+					{
+						const int f = (i + frame) % 20;
+						gfx.DrawSprite( (i % 10) * 78,(i / 10) * 95 + 10,RectI{ (f % 5) * 90,(f % 5) * 90 + 90,(f / 5) * 90,(f / 5) * 90 + 90 },
+							link,SpriteEffect::Chroma{ Colors::Magenta } );
+					}
+					gfx.EndFrame();
+				}
+			} );
+			std::printf( "  %-7s %6.3f ms per frame   %5.2f MB clear + present traffic\n",mode.first,t / 200.0 * 1e3,
+				gfx.GetLastFrameTraffic().GetTotal() / 1e6 );
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// poos: PooStore::ProcessLogic (grid build + avoidance + pursuit) against testing
+	// every other poo, at the density poos end up at around chili (one per 30x30 px)
+
+	std::vector<Vec2> SpreadPoos( int n )
+	{
+		std::mt19937 rng( 1234u );
+		std::uniform_real_distribution<float> d( 0.0f,30.0f * std::sqrt( float( n ) ) );
+		std::vector<Vec2> positions( n );
+		for( auto& p : positions )
+		{
+			p.x = d( rng );
+			p.y = d( rng );
+		}
+		return positions;
+	}
+
+	void BenchPoos()
+	{
+		std::printf( "poos: ProcessLogic per frame, grid vs brute force first poo within %.0f px\n",
+			PooStore::avoidanceRadius );
+		const World world( Graphics::GetScreenRect() );
+		for( int n : { 12,100,1000,5000,20000,50000 } )
+		{
+			std::vector<Vec2> positions = SpreadPoos( n );
+			// same poos again in grid cell order (what list order would be if poos were kept sorted)
+			SpatialGrid grid;
+			grid.Build( positions.data(),n,PooStore::avoidanceRadius );
+			std::vector<Vec2> sorted = positions;
+			std::sort( sorted.begin(),sorted.end(),[&]( const Vec2& a,const Vec2& b )
+			{
+				const float cell = grid.GetCellSize();
+				return int( a.y / cell ) != int( b.y / cell ) ? int( a.y / cell ) < int( b.y / cell ) : a.x < b.x;
+			} );
+			const int reps = std::max( 5,200000 / n );
+			const auto timeLogic = [&]( const std::vector<Vec2>& pos )
+			{
+				PooStore poos( n );
+				for( const auto& p : pos )
+				{
+					poos.Spawn( p );
+				}
+				return Time( reps,[&]() { poos.ProcessLogic( world ); } );
+			};
+			const double tGrid = timeLogic( positions );
+			const double tSorted = timeLogic( sorted );
+			const double tBuild = Time( reps,[&]() { grid.Build( positions.data(),n,PooStore::avoidanceRadius ); } );
+			std::printf( "  %6d poos  ProcessLogic %9.1f us (%5.1f ns/poo, build %5.1f)   cell order %9.1f us (%5.1f ns/poo)",
+				n,tGrid * 1e6,tGrid * 1e9 / n,tBuild * 1e9 / n,tSorted * 1e6,tSorted * 1e9 / n );
+			if( n <= 5000 )
+			{
+				volatile int sink = 0;
+				const double tBrute = Time( std::max( 3,reps / 100 ),[&]()
+				{
+					int found = 0;
+					for( int self = 0; self < n; self++ )
+					{
+						for( int other = 0; other < n; other++ )
+						{
+							if( other != self && (positions[self] - positions[other]).GetLengthSq() <
+								PooStore::avoidanceRadius * PooStore::avoidanceRadius )
+							{
+								found += other;
+								break;
+							}
+						}
+					}
+					sink = found;
+				} );
+				std::printf( "   brute force %9.1f us",tBrute * 1e6 );
+			}
+			std::printf( "\n" );
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// entities: bytes per PooStore / BulletStore slot and time per entity for each pass
+
+	// best of reps, timing only f (then untimed plays back and clears what f queued)
+	double TimeDraw( int reps,RenderQueue& rq,Graphics& gfx,const std::function<void()>& f )
+	{
+		FrameTimer ft;
+		double best = 1e9;
+		for( int i = 0; i < reps; i++ )
+		{
+			ft.Mark();
+			f();
+			best = std::min( best,double( ft.Mark() ) );
+			rq.Render( gfx );
+		}
+		return best;
+	}
+
+	void BenchEntities()
+	{
+		std::printf( "entities: PooStore %d bytes per slot, BulletStore %d bytes per slot\n",
+			int( PooStore::GetSlotBytes() ),int( BulletStore::GetSlotBytes() ) );
+		std::printf( "  ns per entity, best of runs\n" );
+		const World world( Graphics::GetScreenRect() );
+		auto pGfx = MakeGraphics();
+		RenderQueue rq;
+		for( int n : { 12,1000,10000,50000 } )
+		{
+			const int reps = std::max( 5,200000 / n );
+			const std::vector<Vec2> positions = SpreadPoos( n );
+			PooStore poos( n );
+			BulletStore bullets( n );
+			for( int i = 0; i < n; i++ )
+			{
+				poos.Spawn( positions[i] );
+				bullets.Spawn( positions[i],{ 0.6f,0.8f } );
+			}
+			// logic before update, update pulls every poo into the world bounds
+			const double tLogic = Time( reps,[&]() { poos.ProcessLogic( world ); } );
+			const double tPooDraw = TimeDraw( reps,rq,*pGfx,[&]() { poos.Draw( rq ); } );
+			const double tPooUpdate = Time( reps,[&]() { poos.Update( world,1.0f / 60.0f ); } );
+			const double tBulletUpdate = Time( reps,[&]() { bullets.Update( 1.0f / 60.0f ); } );
+			const double tBulletDraw = TimeDraw( reps,rq,*pGfx,[&]() { bullets.Draw( rq ); } );
+			std::printf( "  %6d  poo logic %6.1f  update %6.1f  draw %6.1f   bullet update %6.1f  draw %6.1f\n",n,
+				tLogic * 1e9 / n,tPooUpdate * 1e9 / n,tPooDraw * 1e9 / n,tBulletUpdate * 1e9 / n,tBulletDraw * 1e9 / n );
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// tiles: a 25x18 layer of 32x32 floor5 tiles (fully on screen), every tile drawn with
+	// the old per pixel loop, with DrawSprite row copies, and through Background
+	// (queued and played back on one band, so all three run on this thread)
+
+	// map string as Background reads it, B..L are tiles and A is blank
+	std::string MakeTileMap( int gridWidth,int gridHeight,bool borderOnly )
+	{
+		std::string map;
+		for( int y = 0; y < gridHeight; y++ )
+		{
+			for( int x = 0; x < gridWidth; x++ )
+			{
+				const bool edge = x == 0 || y == 0 || x == gridWidth - 1 || y == gridHeight - 1;
+				map.push_back( borderOnly && !edge ? 'A' : char( 'B' + (x * 7 + y * 3) % 11 ) );
+			}
+		}
+		return map;
+	}
+
+	void BenchTiles()
+	{
+		std::printf( "tiles: ms per 25x18 tile layer, best of 50\n" );
+		const int gridWidth = 25;
+		const int gridHeight = 18;
+		const int tileSize = 32;
+		const Surface& tileset = *Codex<Surface>::Retrieve( L"Images\\floor5.bmp" );
+		auto pGfx = MakeGraphics();
+		Graphics& gfx = *pGfx;
+		RenderQueue rq( 1 );
+		for( bool borderOnly : { false,true } )
+		{
+			const std::string map = MakeTileMap( gridWidth,gridHeight,borderOnly );
+			const auto drawTiles = [&]( const std::function<void( int x,int y,const RectI& src )>& draw )
+			{
+				for( int i = 0; i < gridWidth * gridHeight; i++ )
+				{
+					const int index = map[i] - 'B';
+					if( index >= 0 )
+					{
+						draw( (i % gridWidth) * tileSize,(i / gridWidth) * tileSize,
+							RectI( Vei2{ tileSize * index,0 },tileSize,tileSize ) );
+					}
+				}
+			};
+			const double tPerPixel = Time( 50,[&]()
+			{
+				drawTiles( [&]( int x,int y,const RectI& src ) { PerPixel::DrawSprite( gfx,x,y,src,tileset,PerPixel::Copy{} ); } );
+			} );
+			const double tRows = Time( 50,[&]()
+			{
+				drawTiles( [&]( int x,int y,const RectI& src ) { gfx.DrawSprite( x,y,src,tileset,SpriteEffect::Copy{} ); } );
+			} );
+			const Background bg( Graphics::GetScreenRect(),gridWidth,gridHeight,map );
+			const double tBackground = Time( 50,[&]()
+			{
+				bg.Draw( rq,RenderQueue::Layer::Underlay );
+				rq.Render( gfx );
+			} );
+			std::printf( "  %-7s %3d tiles   per pixel %6.3f   row copy %6.3f (x%.1f)   Background %6.3f\n",
+				borderOnly ? "border" : "solid",bg.GetDrawCount(),tPerPixel * 1e3,tRows * 1e3,tPerPixel / tRows,
+				tBackground * 1e3 );
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	class Section
+	{
+	public:
+		const char* name;
+		void( *run )();
+	};
+	const Section sections[] = {
+		{ "spans",BenchSpans },
+		{ "surfaces",BenchSurfaces },
+		{ "decode",BenchDecode },
+		{ "cache",BenchCache },
+		{ "pipelines",BenchPipelines },
+		{ "bands",BenchBands },
+		{ "atlas",BenchAtlas },
+		{ "stream",BenchStream },
+		{ "upload",BenchUpload },
+		{ "poos",BenchPoos },
+		{ "entities",BenchEntities },
+		{ "tiles",BenchTiles }
+	};
+}
+
+int main( int argc,char** argv )
+{
+	for( const auto& s : sections )
+	{
+		bool selected = argc < 2;
+		for( int i = 1; i < argc; i++ )
+		{
+			selected = selected || std::strcmp( argv[i],s.name ) == 0;
+		}
+		if( selected )
+		{
+			s.run();
+		}
+	}
+	return 0;
+}
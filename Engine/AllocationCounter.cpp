@@ -0,0 +1,189 @@
+#include "AllocationCounter.h"
+#include "ChiliMemory.h"
+#include <cstdlib>
+#include <new>
+
+#ifndef CHILI_COUNT_ALLOCATIONS
+size_t AllocationCounter::GetCount()
+{
+	return 0u;
+}
+
+size_t AllocationCounter::GetFreeCount()
+{
+	return 0u;
+}
+#else
+namespace
+{
+	thread_local size_t count = 0u;
+	thread_local size_t freeCount = 0u;
+
+	void* CountedAlloc( size_t size ) noexcept
+	{
+		count++;
+		// malloc( 0 ) may return nullptr, operator new must not
+		return std::malloc( size > 0u ? size : 1u );
+	}
+
+	template<typename Alloc>
+	void* AllocOrThrow( Alloc alloc )
+	{
+		void* p;
+		while( (p = alloc()) == nullptr )
+		{
+			// standard behavior, give the handler a chance to free something up
+			const std::new_handler handler = std::get_new_handler();
+			if( handler == nullptr )
+			{
+				throw std::bad_alloc();
+			}
+			handler();
+		}
+		return p;
+	}
+
+	void CountedFree( void* p ) noexcept
+	{
+		if( p != nullptr )
+		{
+			freeCount++;
+			std::free( p );
+		}
+	}
+
+#ifdef __cpp_aligned_new
+	void* CountedAlignedAlloc( size_t size,size_t alignment ) noexcept
+	{
+		count++;
+		return aligned_malloc( size > 0u ? size : 1u,alignment );
+	}
+
+	void CountedAlignedFree( void* p ) noexcept
+	{
+		if( p != nullptr )
+		{
+			freeCount++;
+			aligned_free( p );
+		}
+	}
+#endif
+}
+
+size_t AllocationCounter::GetCount()
+{
+	return count;
+}
+
+size_t AllocationCounter::GetFreeCount()
+{
+	return freeCount;
+}
+
+// replacements for the global allocation functions (everything that isn't a placement
+// new ends up here, containers included)
+// the sized deletes are what compilers call when they know the size, they must be
+// replaced along with the rest so every free goes through the same path
+void* operator new( size_t size )
+{
+	return AllocOrThrow( [size]() { return CountedAlloc( size ); } );
+}
+
+void* operator new[]( size_t size )
+{
+	return AllocOrThrow( [size]() { return CountedAlloc( size ); } );
+}
+
+void* operator new( size_t size,const std::nothrow_t& ) noexcept
+{
+	return CountedAlloc( size );
+}
+
+void* operator new[]( size_t size,const std::nothrow_t& ) noexcept
+{
+	return CountedAlloc( size );
+}
+
+void operator delete( void* p ) noexcept
+{
+	CountedFree( p );
+}
+
+void operator delete[]( void* p ) noexcept
+{
+	CountedFree( p );
+}
+
+void operator delete( void* p,size_t ) noexcept
+{
+	CountedFree( p );
+}
+
+void operator delete[]( void* p,size_t ) noexcept
+{
+	CountedFree( p );
+}
+
+void operator delete( void* p,const std::nothrow_t& ) noexcept
+{
+	CountedFree( p );
+}
+
+void operator delete[]( void* p,const std::nothrow_t& ) noexcept
+{
+	CountedFree( p );
+}
+
+#ifdef __cpp_aligned_new
+// over-aligned types (c++17), these come from aligned_malloc so they need their own frees
+void* operator new( size_t size,std::align_val_t alignment )
+{
+	return AllocOrThrow( [=]() { return CountedAlignedAlloc( size,size_t( alignment ) ); } );
+}
+
+void* operator new[]( size_t size,std::align_val_t alignment )
+{
+	return AllocOrThrow( [=]() { return CountedAlignedAlloc( size,size_t( alignment ) ); } );
+}
+
+void* operator new( size_t size,std::align_val_t alignment,const std::nothrow_t& ) noexcept
+{
+	return CountedAlignedAlloc( size,size_t( alignment ) );
+}
+
+void* operator new[]( size_t size,std::align_val_t alignment,const std::nothrow_t& ) noexcept
+{
+	return CountedAlignedAlloc( size,size_t( alignment ) );
+}
+
+void operator delete( void* p,std::align_val_t ) noexcept
+{
+	CountedAlignedFree( p );
+}
+
+void operator delete[]( void* p,std::align_val_t ) noexcept
+{
+	CountedAlignedFree( p );
+}
+
+void operator delete( void* p,size_t,std::align_val_t ) noexcept
+{
+	CountedAlignedFree( p );
+}
+
+void operator delete[]( void* p,size_t,std::align_val_t ) noexcept
+{
+	CountedAlignedFree( p );
+}
+
+void operator delete( void* p,std::align_val_t,const std::nothrow_t& ) noexcept
+{
+	CountedAlignedFree( p );
+}
+
+void operator delete[]( void* p,std::align_val_t,const std::nothrow_t& ) noexcept
+{
+	CountedAlignedFree( p );
+}
+#endif
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+// counts heap allocations and frees made through operator new / delete, per thread
+// debug builds replace the global operators to do the counting, release builds
+// leave them alone and always report 0 (see Game::UpdateModel for what it checks)
+// unless CHILI_COUNT_ALLOCATIONS is defined (the headless frame test turns it on)
+//
+// the counts are thread_local: only allocations made on the calling thread show up,
+// so whatever the RenderQueue band workers allocate is invisible to the main thread
+// (render with a single band to have everything counted)
+#if !defined( NDEBUG ) && !defined( CHILI_COUNT_ALLOCATIONS )
+#define CHILI_COUNT_ALLOCATIONS
+#endif
+class AllocationCounter
+{
+public:
+#ifdef CHILI_COUNT_ALLOCATIONS
+	static constexpr bool enabled = true;
+#else
+	static constexpr bool enabled = false;
+#endif
+	// allocations made on the calling thread so far
+	static size_t GetCount();
+	// frees (of non-null pointers) made on the calling thread so far
+	static size_t GetFreeCount();
+};
@@ -1,45 +1,82 @@
 #include "Animation.h"
 #include "SpriteEffect.h"
 
-Animation::Animation( int x,int y,int width,int height,int count,
-					  const Surface* sprite,float holdTime,Color chroma )
+AnimationClip::AnimationClip( int x,int y,int width,int height,int count,
+							  const Surface* sprite,float holdTime,Color chroma )
 	:
-	sprite( sprite ),
-	holdTime( holdTime ),
-	chroma( chroma )
+	holdTime( holdTime )
 {
+	frames.reserve( count );
 	for( int i = 0; i < count; i++ )
 	{
-		frames.emplace_back( x + i * width,x + (i + 1) * width,y,y + height );
+		frames.emplace_back( *sprite,RectI{ x + i * width,x + (i + 1) * width,y,y + height },chroma );
 	}
 }
 
-void Animation::Draw( const Vei2& pos,Graphics& gfx,bool mirrored ) const
+void AnimationClip::Draw( int iFrame,const Vei2& pos,RenderQueue& rq,bool mirrored ) const
 {
-	gfx.DrawSprite( pos.x,pos.y,frames[iCurFrame],*sprite,
-					SpriteEffect::Chroma{ chroma },mirrored );
+	// compiled frame only has opaque pixels, so a straight copy does the chroma keying
+	rq.DrawSprite( pos.x,pos.y,frames[iFrame],SpriteEffect::Copy{},mirrored );
 }
 
-void Animation::DrawColor( const Vei2& pos,Graphics& gfx,Color c,bool mirrored ) const
+void AnimationClip::DrawColor( int iFrame,const Vei2& pos,RenderQueue& rq,Color c,bool mirrored ) const
 {
-	gfx.DrawSprite( pos.x,pos.y,frames[iCurFrame],*sprite,
-					SpriteEffect::Substitution{ chroma,c },mirrored );
+	rq.DrawSprite( pos.x,pos.y,frames[iFrame],SpriteEffect::Fill{ c },mirrored );
 }
 
-void Animation::Update( float dt )
+int AnimationClip::GetFrameCount() const
+{
+	return int( frames.size() );
+}
+
+float AnimationClip::GetHoldTime() const
+{
+	return holdTime;
+}
+
+void AnimationClip::PrepareMirrored() const
 {
+	for( const auto& f : frames )
+	{
+		f.GetMirrored();
+	}
+}
+
+void AnimationCursor::Update( const AnimationClip& clip,float dt )
+{
+	const float holdTime = clip.GetHoldTime();
 	curFrameTime += dt;
 	while( curFrameTime >= holdTime )
 	{
-		Advance();
+		if( ++iCurFrame >= clip.GetFrameCount() )
+		{
+			iCurFrame = 0;
+		}
 		curFrameTime -= holdTime;
 	}
 }
 
-void Animation::Advance()
+int AnimationCursor::GetFrame() const
 {
-	if( ++iCurFrame >= frames.size() )
-	{
-		iCurFrame = 0;
-	}
+	return iCurFrame;
+}
+
+Animation::Animation( const AnimationClip& clip )
+	:
+	pClip( &clip )
+{}
+
+void Animation::Draw( const Vei2& pos,RenderQueue& rq,bool mirrored ) const
+{
+	pClip->Draw( cursor.GetFrame(),pos,rq,mirrored );
+}
+
+void Animation::DrawColor( const Vei2& pos,RenderQueue& rq,Color c,bool mirrored ) const
+{
+	pClip->DrawColor( cursor.GetFrame(),pos,rq,c,mirrored );
+}
+
+void Animation::Update( float dt )
+{
+	cursor.Update( *pClip,dt );
 }
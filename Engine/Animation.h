@@ -1,24 +1,53 @@
 #pragma once
 
 #include "Surface.h"
-#include "Graphics.h"
+#include "CompiledSprite.h"
+#include "RenderQueue.h"
 #include <vector>
 
-class Animation
+// the frames of an animation, compiled once and then shared by everything that plays it
+// (immutable after construction)
+class AnimationClip
 {
 public:
-	Animation( int x,int y,int width,int height,int count,const Surface* sprite,float holdTime,Color chroma = Colors::Magenta );
-	void Draw( const Vei2& pos,Graphics& gfx,bool mirrored = false ) const;
+	AnimationClip( int x,int y,int width,int height,int count,const Surface* sprite,float holdTime,Color chroma = Colors::Magenta );
+	AnimationClip( const AnimationClip& ) = delete;
+	AnimationClip& operator=( const AnimationClip& ) = delete;
+	void Draw( int iFrame,const Vei2& pos,RenderQueue& rq,bool mirrored = false ) const;
 	// this version of draw replaces all opaque pixels with specified color
-	void DrawColor( const Vei2& pos,Graphics& gfx,Color c,bool mirrored = false ) const;
-	void Update( float dt );
+	void DrawColor( int iFrame,const Vei2& pos,RenderQueue& rq,Color c,bool mirrored = false ) const;
+	int GetFrameCount() const;
+	float GetHoldTime() const;
+	// builds the mirrored copies of the frames now instead of on their first mirrored draw
+	void PrepareMirrored() const;
 private:
-	void Advance();
+	// each frame rect is compiled into opaque runs at construction
+	std::vector<CompiledSprite> frames;
+	float holdTime;
+};
+
+// playback position in a clip (the clip is passed in, not stored)
+// small enough to keep one per entity in a plain array
+class AnimationCursor
+{
+public:
+	void Update( const AnimationClip& clip,float dt );
+	int GetFrame() const;
 private:
-	Color chroma;
-	const Surface* sprite;
-	std::vector<RectI> frames;
 	int iCurFrame = 0;
-	float holdTime;
 	float curFrameTime = 0.0f;
-};
\ No newline at end of file
+};
+
+// a cursor that remembers its clip, for entities that play a few clips of their own
+class Animation
+{
+public:
+	Animation( const AnimationClip& clip );
+	void Draw( const Vei2& pos,RenderQueue& rq,bool mirrored = false ) const;
+	// this version of draw replaces all opaque pixels with specified color
+	void DrawColor( const Vei2& pos,RenderQueue& rq,Color c,bool mirrored = false ) const;
+	void Update( float dt );
+private:
+	const AnimationClip* pClip;
+	AnimationCursor cursor;
+};
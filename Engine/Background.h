@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Graphics.h"
+#include "RenderQueue.h"
 #include "Surface.h"
 #include "SpriteEffect.h"
 #include "Codex.h"
@@ -9,6 +9,14 @@
 
 class Background
 {
+private:
+	// non-blank tile and where it goes on the screen
+	class TileDraw
+	{
+	public:
+		Vei2 pos;
+		int index;
+	};
 public:
 	Background( const RectI& bgRegion,int gridWidth,int gridHeight,const std::string& map )
 		:
@@ -34,9 +42,44 @@ public:
 				tiles.push_back( *mi - 'B' );
 			}
 		}
+		// compact list of the tiles that actually need drawing
+		BuildTileList();
 	}
-	void Draw( Graphics& gfx ) const
+	// layer decides whether this background goes under or over the entities
+	void Draw( RenderQueue& rq,RenderQueue::Layer layer ) const
 	{
+		// tiles don't overlap, so they all share one key
+		rq.SetSortKey( layer,0 );
+		// blank tiles are not in the list, so mostly empty overlays cost
+		// only as much as the tiles that are actually there
+		for( const auto& t : tileDraws )
+		{
+			rq.DrawSprite( t.pos.x,t.pos.y,
+				tileRects[t.index],*pTilesetSurface,SpriteEffect::Copy{}
+			);
+		}
+	}
+	// draws Draw records
+	int GetDrawCount() const
+	{
+		return int( tileDraws.size() );
+	}
+	// true if drawing the layer writes every pixel of rect
+	// (only a layer without blank tiles covers anything)
+	bool Covers( const RectI& rect ) const
+	{
+		const bool solid = int( tileDraws.size() ) == gridWidth * gridHeight;
+		return solid && rect.IsContainedBy( RectI( origin,gridWidth * tileSize,gridHeight * tileSize ) );
+	}
+private:
+	int GetTileAt( int x,int y ) const
+	{
+		return tiles[y * gridWidth + x];
+	}
+	// collect all non-blank tiles (in grid order) with their screen positions
+	void BuildTileList()
+	{
+		tileDraws.clear();
 		for( int y = 0; y < gridHeight; y++ )
 		{
 			for( int x = 0; x < gridWidth; x++ )
@@ -45,18 +88,11 @@ public:
 				// negative values are skipped (blank tiles)
 				if( index >= 0 )
 				{
-					gfx.DrawSprite( x * tileSize + origin.x,y * tileSize + origin.y,
-						tileRects[index],*pTilesetSurface,SpriteEffect::Copy{}
-					);
+					tileDraws.push_back( { Vei2{ x * tileSize,y * tileSize } + origin,index } );
 				}
 			}
 		}
 	}
-private:
-	int GetTileAt( int x,int y ) const
-	{
-		return tiles[y * gridWidth + x];
-	}
 private:
 	// tileset image for background
 	const Surface* pTilesetSurface;
@@ -66,6 +102,8 @@ private:
 	std::vector<RectI> tileRects;
 	// grid of tiles (indices into the tileRect vector)
 	std::vector<int> tiles;
+	// non-blank tiles only (what tiled mode actually draws)
+	std::vector<TileDraw> tileDraws;
 	// number of tiles in set
 	int nTiles = 11;
 	// tile dimensions in pixels
@@ -73,4 +111,4 @@ private:
 	// grid dimensions in tiles
 	int gridWidth;
 	int gridHeight;
-};
\ No newline at end of file
+};
@@ -0,0 +1,569 @@
+#include "BlitKernels.h"
+#include "KernelRegistry.h"
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#ifdef CHILI_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	typedef void( *ChromaKernel )( const Color*,int,Color*,int,Color );
+	typedef void( *AlphaBlendKernel )( const Color*,int,Color*,int );
+	typedef void( *CopyKernel )( const Color*,int,Color*,int );
+	typedef void( *StreamCopyKernel )( const Color*,Color*,int );
+
+	void ChromaScalar( const Color* pSrc,int srcStep,Color* pDst,int n,Color chroma )
+	{
+		for( int i = 0; i < n; i++,pSrc += srcStep )
+		{
+			if( *pSrc != chroma )
+			{
+				pDst[i] = *pSrc;
+			}
+		}
+	}
+
+	void AlphaBlendScalar( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		for( int i = 0; i < n; i++,pSrc += srcStep )
+		{
+			const Color src = *pSrc;
+			// pre-extract alpha complement
+			const unsigned int cAlpha = 255u - src.GetA();
+			// reject drawing pixels if alpha == 0 (full transparent)
+			if( cAlpha != 255u )
+			{
+				// red and blue are scaled together in one multiply, green separately
+				// (see SpriteEffect::AlphaBlendBaked for the full explanation)
+				const unsigned int dst = pDst[i].dword;
+				const unsigned int rb = (((dst & 0xFF00FFu) * cAlpha) >> 8) & 0xFF00FFu;
+				const unsigned int g = (((dst & 0x00FF00u) * cAlpha) >> 8) & 0x00FF00u;
+				pDst[i] = rb + g + src.dword;
+			}
+		}
+	}
+
+	void CopyScalar( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		if( srcStep == 1 )
+		{
+			memcpy( pDst,pSrc,sizeof( Color ) * n );
+		}
+		else
+		{
+			for( int i = 0; i < n; i++,pSrc += srcStep )
+			{
+				pDst[i] = *pSrc;
+			}
+		}
+	}
+
+	// no simd, the stores stay cached
+	void StreamCopyScalar( const Color* pSrc,Color* pDst,int n )
+	{
+		memcpy( pDst,pSrc,sizeof( Color ) * n );
+	}
+
+#ifdef CHILI_X86
+	// 4 pixels at a time, blend of src/dst selected by chroma compare mask
+	// mirrored spans load the 4 pixels to the left and reverse them in register
+	template<bool mirrored>
+	CHILI_TARGET_SSE2 void ChromaSSE2Span( const Color* pSrc,Color* pDst,int n,Color chroma )
+	{
+		const __m128i key = _mm_set1_epi32( int( chroma.dword ) );
+		int i = 0;
+		for( ; i + 4 <= n; i += 4 )
+		{
+			__m128i src;
+			if( mirrored )
+			{
+				src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc - i - 3 ) );
+				src = _mm_shuffle_epi32( src,_MM_SHUFFLE( 0,1,2,3 ) );
+			}
+			else
+			{
+				src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc + i ) );
+			}
+			// all lanes set where pixel is transparent
+			const __m128i keyed = _mm_cmpeq_epi32( src,key );
+			const int keyedBits = _mm_movemask_epi8( keyed );
+			__m128i* const pOut = reinterpret_cast<__m128i*>( pDst + i );
+			if( keyedBits == 0xFFFF )
+			{
+				// fully transparent, nothing to do
+				continue;
+			}
+			else if( keyedBits == 0 )
+			{
+				// fully opaque, no need to read the destination
+				_mm_storeu_si128( pOut,src );
+			}
+			else
+			{
+				const __m128i dst = _mm_loadu_si128( pOut );
+				_mm_storeu_si128( pOut,_mm_or_si128(
+					_mm_and_si128( keyed,dst ),
+					_mm_andnot_si128( keyed,src )
+				) );
+			}
+		}
+		// leftover pixels
+		ChromaScalar( mirrored ? pSrc - i : pSrc + i,mirrored ? -1 : 1,pDst + i,n - i,chroma );
+	}
+
+	CHILI_TARGET_SSE2 void ChromaSSE2( const Color* pSrc,int srcStep,Color* pDst,int n,Color chroma )
+	{
+		if( srcStep == 1 )
+		{
+			ChromaSSE2Span<false>( pSrc,pDst,n,chroma );
+		}
+		else
+		{
+			ChromaSSE2Span<true>( pSrc,pDst,n,chroma );
+		}
+	}
+
+	// 8 pixels at a time, written with a masked store (transparent lanes untouched)
+	template<bool mirrored>
+	CHILI_TARGET_AVX2 void ChromaAVX2Span( const Color* pSrc,Color* pDst,int n,Color chroma )
+	{
+		const __m256i key = _mm256_set1_epi32( int( chroma.dword ) );
+		const __m256i ones = _mm256_set1_epi32( -1 );
+		const __m256i reverse = _mm256_setr_epi32( 7,6,5,4,3,2,1,0 );
+		int i = 0;
+		for( ; i + 8 <= n; i += 8 )
+		{
+			__m256i src;
+			if( mirrored )
+			{
+				src = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pSrc - i - 7 ) );
+				src = _mm256_permutevar8x32_epi32( src,reverse );
+			}
+			else
+			{
+				src = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pSrc + i ) );
+			}
+			// all lanes set where pixel is opaque
+			const __m256i opaque = _mm256_xor_si256( _mm256_cmpeq_epi32( src,key ),ones );
+			const int opaqueBits = _mm256_movemask_epi8( opaque );
+			if( opaqueBits == -1 )
+			{
+				_mm256_storeu_si256( reinterpret_cast<__m256i*>( pDst + i ),src );
+			}
+			else if( opaqueBits != 0 )
+			{
+				_mm256_maskstore_epi32( reinterpret_cast<int*>( pDst + i ),opaque,src );
+			}
+		}
+		// leftover pixels (less than 8)
+		ChromaScalar( mirrored ? pSrc - i : pSrc + i,mirrored ? -1 : 1,pDst + i,n - i,chroma );
+	}
+
+	CHILI_TARGET_AVX2 void ChromaAVX2( const Color* pSrc,int srcStep,Color* pDst,int n,Color chroma )
+	{
+		if( srcStep == 1 )
+		{
+			ChromaAVX2Span<false>( pSrc,pDst,n,chroma );
+		}
+		else
+		{
+			ChromaAVX2Span<true>( pSrc,pDst,n,chroma );
+		}
+	}
+
+	// 4 premultiplied pixels at a time
+	// each channel is widened to 16 bits so dst * calpha can't overflow, then
+	// dst channel * calpha >> 8 is packed back and added to src (like the scalar version)
+	template<bool mirrored>
+	CHILI_TARGET_SSE2 void AlphaBlendSSE2Span( const Color* pSrc,Color* pDst,int n )
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i full = _mm_set1_epi32( 255 );
+		int i = 0;
+		for( ; i + 4 <= n; i += 4 )
+		{
+			__m128i src;
+			if( mirrored )
+			{
+				src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc - i - 3 ) );
+				src = _mm_shuffle_epi32( src,_MM_SHUFFLE( 0,1,2,3 ) );
+			}
+			else
+			{
+				src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc + i ) );
+			}
+			__m128i* const pOut = reinterpret_cast<__m128i*>( pDst + i );
+			const __m128i alpha = _mm_srli_epi32( src,24 );
+			const __m128i clear = _mm_cmpeq_epi32( alpha,zero );
+			const int clearBits = _mm_movemask_epi8( clear );
+			// whole block transparent, leave dst alone
+			if( clearBits == 0xFFFF )
+			{
+				continue;
+			}
+			// whole block opaque, src is the result
+			if( _mm_movemask_epi8( _mm_cmpeq_epi32( alpha,full ) ) == 0xFFFF )
+			{
+				_mm_storeu_si128( pOut,src );
+				continue;
+			}
+			// calpha in the r,g,b bytes of each pixel, 0 in the alpha byte
+			// (so dst alpha is dropped and src alpha is kept, same as scalar)
+			const __m128i cAlpha = _mm_sub_epi32( full,alpha );
+			const __m128i mul = _mm_or_si128( cAlpha,
+				_mm_or_si128( _mm_slli_epi32( cAlpha,8 ),_mm_slli_epi32( cAlpha,16 ) ) );
+			const __m128i dst = _mm_loadu_si128( pOut );
+			const __m128i lo = _mm_srli_epi16( _mm_mullo_epi16(
+				_mm_unpacklo_epi8( dst,zero ),_mm_unpacklo_epi8( mul,zero ) ),8 );
+			const __m128i hi = _mm_srli_epi16( _mm_mullo_epi16(
+				_mm_unpackhi_epi8( dst,zero ),_mm_unpackhi_epi8( mul,zero ) ),8 );
+			const __m128i blend = _mm_add_epi32( _mm_packus_epi16( lo,hi ),src );
+			// fully transparent pixels keep their dst
+			_mm_storeu_si128( pOut,_mm_or_si128(
+				_mm_and_si128( clear,dst ),
+				_mm_andnot_si128( clear,blend )
+			) );
+		}
+		AlphaBlendScalar( mirrored ? pSrc - i : pSrc + i,mirrored ? -1 : 1,pDst + i,n - i );
+	}
+
+	CHILI_TARGET_SSE2 void AlphaBlendSSE2( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		if( srcStep == 1 )
+		{
+			AlphaBlendSSE2Span<false>( pSrc,pDst,n );
+		}
+		else
+		{
+			AlphaBlendSSE2Span<true>( pSrc,pDst,n );
+		}
+	}
+
+	// same as the sse2 version, 8 pixels at a time
+	// (unpack/pack work inside 128-bit lanes, but they undo each other so order is kept)
+	template<bool mirrored>
+	CHILI_TARGET_AVX2 void AlphaBlendAVX2Span( const Color* pSrc,Color* pDst,int n )
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i full = _mm256_set1_epi32( 255 );
+		const __m256i reverse = _mm256_setr_epi32( 7,6,5,4,3,2,1,0 );
+		int i = 0;
+		for( ; i + 8 <= n; i += 8 )
+		{
+			__m256i src;
+			if( mirrored )
+			{
+				src = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pSrc - i - 7 ) );
+				src = _mm256_permutevar8x32_epi32( src,reverse );
+			}
+			else
+			{
+				src = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pSrc + i ) );
+			}
+			__m256i* const pOut = reinterpret_cast<__m256i*>( pDst + i );
+			const __m256i alpha = _mm256_srli_epi32( src,24 );
+			const __m256i clear = _mm256_cmpeq_epi32( alpha,zero );
+			const int clearBits = _mm256_movemask_epi8( clear );
+			if( clearBits == -1 )
+			{
+				continue;
+			}
+			if( _mm256_movemask_epi8( _mm256_cmpeq_epi32( alpha,full ) ) == -1 )
+			{
+				_mm256_storeu_si256( pOut,src );
+				continue;
+			}
+			const __m256i cAlpha = _mm256_sub_epi32( full,alpha );
+			const __m256i mul = _mm256_or_si256( cAlpha,
+				_mm256_or_si256( _mm256_slli_epi32( cAlpha,8 ),_mm256_slli_epi32( cAlpha,16 ) ) );
+			const __m256i dst = _mm256_loadu_si256( pOut );
+			const __m256i lo = _mm256_srli_epi16( _mm256_mullo_epi16(
+				_mm256_unpacklo_epi8( dst,zero ),_mm256_unpacklo_epi8( mul,zero ) ),8 );
+			const __m256i hi = _mm256_srli_epi16( _mm256_mullo_epi16(
+				_mm256_unpackhi_epi8( dst,zero ),_mm256_unpackhi_epi8( mul,zero ) ),8 );
+			const __m256i blend = _mm256_add_epi32( _mm256_packus_epi16( lo,hi ),src );
+			_mm256_storeu_si256( pOut,_mm256_blendv_epi8( blend,dst,clear ) );
+		}
+		AlphaBlendScalar( mirrored ? pSrc - i : pSrc + i,mirrored ? -1 : 1,pDst + i,n - i );
+	}
+
+	CHILI_TARGET_AVX2 void AlphaBlendAVX2( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		if( srcStep == 1 )
+		{
+			AlphaBlendAVX2Span<false>( pSrc,pDst,n );
+		}
+		else
+		{
+			AlphaBlendAVX2Span<true>( pSrc,pDst,n );
+		}
+	}
+
+	// forward spans are a memcpy, mirrored spans load 4 pixels to the left and
+	// reverse them in register
+	CHILI_TARGET_SSE2 void CopySSE2( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		if( srcStep == 1 )
+		{
+			memcpy( pDst,pSrc,sizeof( Color ) * n );
+			return;
+		}
+		int i = 0;
+		for( ; i + 4 <= n; i += 4 )
+		{
+			const __m128i src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc - i - 3 ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + i ),
+				_mm_shuffle_epi32( src,_MM_SHUFFLE( 0,1,2,3 ) ) );
+		}
+		CopyScalar( pSrc - i,-1,pDst + i,n - i );
+	}
+
+	// streams to 16 byte aligned dst, the stores go around the cache
+	CHILI_TARGET_SSE2 void StreamCopySSE2( const Color* pSrc,Color* pDst,int n )
+	{
+		int i = 0;
+		for( ; i < n && (reinterpret_cast<uintptr_t>( pDst + i ) & 15u) != 0u; i++ )
+		{
+			pDst[i] = pSrc[i];
+		}
+		for( ; i + 4 <= n; i += 4 )
+		{
+			_mm_stream_si128( reinterpret_cast<__m128i*>( pDst + i ),
+				_mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc + i ) ) );
+		}
+		// streaming stores are weakly ordered, fence them before the buffer is
+		// handed on (a plain release store doesn't order them on x86)
+		_mm_sfence();
+		CopyScalar( pSrc + i,1,pDst + i,n - i );
+	}
+
+	// same as the sse2 version, 8 pixels at a time
+	CHILI_TARGET_AVX2 void CopyAVX2( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		if( srcStep == 1 )
+		{
+			memcpy( pDst,pSrc,sizeof( Color ) * n );
+			return;
+		}
+		const __m256i reverse = _mm256_setr_epi32( 7,6,5,4,3,2,1,0 );
+		int i = 0;
+		for( ; i + 8 <= n; i += 8 )
+		{
+			const __m256i src = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pSrc - i - 7 ) );
+			_mm256_storeu_si256( reinterpret_cast<__m256i*>( pDst + i ),
+				_mm256_permutevar8x32_epi32( src,reverse ) );
+		}
+		CopyScalar( pSrc - i,-1,pDst + i,n - i );
+	}
+
+	// same as the sse2 version, 8 pixels at a time to 32 byte aligned dst
+	CHILI_TARGET_AVX2 void StreamCopyAVX2( const Color* pSrc,Color* pDst,int n )
+	{
+		int i = 0;
+		for( ; i < n && (reinterpret_cast<uintptr_t>( pDst + i ) & 31u) != 0u; i++ )
+		{
+			pDst[i] = pSrc[i];
+		}
+		for( ; i + 8 <= n; i += 8 )
+		{
+			_mm256_stream_si256( reinterpret_cast<__m256i*>( pDst + i ),
+				_mm256_loadu_si256( reinterpret_cast<const __m256i*>( pSrc + i ) ) );
+		}
+		_mm_sfence();
+		CopyScalar( pSrc + i,1,pDst + i,n - i );
+	}
+#endif
+
+#ifdef CHILI_AVX512
+	// shifts and permutes below use the zero-masked forms with every lane enabled
+	// (same instructions, but the plain forms pass an undefined vector through, which
+	// gcc 12 reports as maybe-uninitialized)
+	constexpr __mmask16 allLanes = 0xFFFF;
+
+	// 16 pixels at a time, the compare gives the store mask directly
+	template<bool mirrored>
+	CHILI_TARGET_AVX512 void ChromaAVX512Span( const Color* pSrc,Color* pDst,int n,Color chroma )
+	{
+		const __m512i key = _mm512_set1_epi32( int( chroma.dword ) );
+		const __m512i reverse = _mm512_setr_epi32( 15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0 );
+		int i = 0;
+		for( ; i + 16 <= n; i += 16 )
+		{
+			__m512i src;
+			if( mirrored )
+			{
+				src = _mm512_loadu_si512( pSrc - i - 15 );
+				src = _mm512_maskz_permutexvar_epi32( allLanes,reverse,src );
+			}
+			else
+			{
+				src = _mm512_loadu_si512( pSrc + i );
+			}
+			_mm512_mask_storeu_epi32( pDst + i,_mm512_cmpneq_epi32_mask( src,key ),src );
+		}
+		ChromaScalar( mirrored ? pSrc - i : pSrc + i,mirrored ? -1 : 1,pDst + i,n - i,chroma );
+	}
+
+	CHILI_TARGET_AVX512 void ChromaAVX512( const Color* pSrc,int srcStep,Color* pDst,int n,Color chroma )
+	{
+		if( srcStep == 1 )
+		{
+			ChromaAVX512Span<false>( pSrc,pDst,n,chroma );
+		}
+		else
+		{
+			ChromaAVX512Span<true>( pSrc,pDst,n,chroma );
+		}
+	}
+
+	// same as the avx2 version, 16 pixels at a time
+	// (fully transparent pixels are left out of the store mask instead of blended back)
+	template<bool mirrored>
+	CHILI_TARGET_AVX512 void AlphaBlendAVX512Span( const Color* pSrc,Color* pDst,int n )
+	{
+		const __m512i zero = _mm512_setzero_si512();
+		const __m512i full = _mm512_set1_epi32( 255 );
+		const __m512i reverse = _mm512_setr_epi32( 15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0 );
+		int i = 0;
+		for( ; i + 16 <= n; i += 16 )
+		{
+			__m512i src;
+			if( mirrored )
+			{
+				src = _mm512_loadu_si512( pSrc - i - 15 );
+				src = _mm512_maskz_permutexvar_epi32( allLanes,reverse,src );
+			}
+			else
+			{
+				src = _mm512_loadu_si512( pSrc + i );
+			}
+			Color* const pOut = pDst + i;
+			const __m512i alpha = _mm512_maskz_srli_epi32( allLanes,src,24 );
+			const __mmask16 visible = _mm512_cmpneq_epi32_mask( alpha,zero );
+			if( visible == 0 )
+			{
+				continue;
+			}
+			if( _mm512_cmpeq_epi32_mask( alpha,full ) == 0xFFFF )
+			{
+				_mm512_storeu_si512( pOut,src );
+				continue;
+			}
+			const __m512i cAlpha = _mm512_sub_epi32( full,alpha );
+			const __m512i mul = _mm512_or_si512( cAlpha,
+				_mm512_or_si512( _mm512_maskz_slli_epi32( allLanes,cAlpha,8 ),_mm512_maskz_slli_epi32( allLanes,cAlpha,16 ) ) );
+			const __m512i dst = _mm512_loadu_si512( pOut );
+			const __m512i lo = _mm512_srli_epi16( _mm512_mullo_epi16(
+				_mm512_unpacklo_epi8( dst,zero ),_mm512_unpacklo_epi8( mul,zero ) ),8 );
+			const __m512i hi = _mm512_srli_epi16( _mm512_mullo_epi16(
+				_mm512_unpackhi_epi8( dst,zero ),_mm512_unpackhi_epi8( mul,zero ) ),8 );
+			const __m512i blend = _mm512_add_epi32( _mm512_packus_epi16( lo,hi ),src );
+			_mm512_mask_storeu_epi32( pOut,visible,blend );
+		}
+		AlphaBlendScalar( mirrored ? pSrc - i : pSrc + i,mirrored ? -1 : 1,pDst + i,n - i );
+	}
+
+	CHILI_TARGET_AVX512 void AlphaBlendAVX512( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		if( srcStep == 1 )
+		{
+			AlphaBlendAVX512Span<false>( pSrc,pDst,n );
+		}
+		else
+		{
+			AlphaBlendAVX512Span<true>( pSrc,pDst,n );
+		}
+	}
+
+	// same as the avx2 version, 16 pixels at a time
+	CHILI_TARGET_AVX512 void CopyAVX512( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		if( srcStep == 1 )
+		{
+			memcpy( pDst,pSrc,sizeof( Color ) * n );
+			return;
+		}
+		const __m512i reverse = _mm512_setr_epi32( 15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0 );
+		int i = 0;
+		for( ; i + 16 <= n; i += 16 )
+		{
+			_mm512_storeu_si512( pDst + i,_mm512_maskz_permutexvar_epi32( allLanes,reverse,_mm512_loadu_si512( pSrc - i - 15 ) ) );
+		}
+		CopyScalar( pSrc - i,-1,pDst + i,n - i );
+	}
+
+	// same as the avx2 version, 16 pixels at a time to 64 byte aligned dst
+	CHILI_TARGET_AVX512 void StreamCopyAVX512( const Color* pSrc,Color* pDst,int n )
+	{
+		int i = 0;
+		for( ; i < n && (reinterpret_cast<uintptr_t>( pDst + i ) & 63u) != 0u; i++ )
+		{
+			pDst[i] = pSrc[i];
+		}
+		for( ; i + 16 <= n; i += 16 )
+		{
+			_mm512_stream_si512( reinterpret_cast<__m512i*>( pDst + i ),_mm512_loadu_si512( pSrc + i ) );
+		}
+		_mm_sfence();
+		CopyScalar( pSrc + i,1,pDst + i,n - i );
+	}
+#endif
+
+	// kernels are bound at startup, and again if the tier limit changes (see KernelRegistry)
+	KernelSlot<ChromaKernel> chromaSlot(
+		ChromaScalar,
+		CHILI_SSE2_KERNEL( ChromaSSE2 ),
+		CHILI_AVX2_KERNEL( ChromaAVX2 ),
+		CHILI_AVX512_KERNEL( ChromaAVX512 )
+	);
+	KernelSlot<AlphaBlendKernel> alphaBlendSlot(
+		AlphaBlendScalar,
+		CHILI_SSE2_KERNEL( AlphaBlendSSE2 ),
+		CHILI_AVX2_KERNEL( AlphaBlendAVX2 ),
+		CHILI_AVX512_KERNEL( AlphaBlendAVX512 )
+	);
+	KernelSlot<CopyKernel> copySlot(
+		CopyScalar,
+		CHILI_SSE2_KERNEL( CopySSE2 ),
+		CHILI_AVX2_KERNEL( CopyAVX2 ),
+		CHILI_AVX512_KERNEL( CopyAVX512 )
+	);
+	KernelSlot<StreamCopyKernel> streamCopySlot(
+		StreamCopyScalar,
+		CHILI_SSE2_KERNEL( StreamCopySSE2 ),
+		CHILI_AVX2_KERNEL( StreamCopyAVX2 ),
+		CHILI_AVX512_KERNEL( StreamCopyAVX512 )
+	);
+}
+
+namespace BlitKernels
+{
+	void Chroma( const Color* pSrc,int srcStep,Color* pDst,int n,Color chroma )
+	{
+		chromaSlot.Get()( pSrc,srcStep,pDst,n,chroma );
+	}
+	void AlphaBlend( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		alphaBlendSlot.Get()( pSrc,srcStep,pDst,n );
+	}
+	void Copy( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		copySlot.Get()( pSrc,srcStep,pDst,n );
+	}
+	void StreamCopy( const Color* pSrc,Color* pDst,int n )
+	{
+		streamCopySlot.Get()( pSrc,pDst,n );
+	}
+	void Fill( Color* pDst,int n,Color c )
+	{
+		// plain stores (gcc vectorizes this loop over the dwords, but not std::fill over Color)
+		for( int i = 0; i < n; i++ )
+		{
+			pDst[i].dword = c.dword;
+		}
+	}
+}
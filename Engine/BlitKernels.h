@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Colors.h"
+
+// row span kernels used by the sprite effects
+// the best implementation (avx-512 / avx2 / sse2 / scalar) is bound by KernelRegistry
+// all versions produce exactly the same output
+namespace BlitKernels
+{
+	// copies every pixel of the span that does not match the chroma key
+	// (pSrc walked by srcStep, +1 for normal or -1 for mirrored)
+	void Chroma( const Color* pSrc,int srcStep,Color* pDst,int n,Color chroma );
+	// blends premultiplied alpha pixels (see Surface::BakeAlpha) onto the span
+	// dst = src + dst * (255 - alpha) / 256, alpha == 0 leaves dst untouched
+	void AlphaBlend( const Color* pSrc,int srcStep,Color* pDst,int n );
+	// copies the span unchanged (opaque blits, see SpriteEffect::Copy)
+	// plain cached stores, whatever is drawn next usually reads the span right back
+	void Copy( const Color* pSrc,int srcStep,Color* pDst,int n );
+	// forward copy with streaming stores that go around the cache, for memory that is
+	// written once and never read by the cpu (the mapped, write-combined upload texture)
+	void StreamCopy( const Color* pSrc,Color* pDst,int n );
+	// sets the whole span to one color
+	void Fill( Color* pDst,int n,Color c );
+}
@@ -12,25 +12,32 @@ public:
 	template<class Entity>
 	void Adjust( Entity& e ) const
 	{
-		const RectF entity_rect = e.GetHitbox();
+		e.DisplaceBy( GetDisplacement( e.GetHitbox() ) );
+	}
+	// how far a hitbox has to move to be back inside
+	// (for entities that are stored as plain data, see PooStore)
+	Vec2 GetDisplacement( const RectF& entity_rect ) const
+	{
+		Vec2 d = { 0.0f,0.0f };
 		// simultaneous left and right collision doesn't make sense
 		// will not be considered
 		if( entity_rect.left < rect.left )
 		{
-			e.DisplaceBy( { rect.left - entity_rect.left,0.0f } );
+			d.x = rect.left - entity_rect.left;
 		}
 		else if( entity_rect.right > rect.right )
 		{
-			e.DisplaceBy( { rect.right - entity_rect.right,0.0f } );
+			d.x = rect.right - entity_rect.right;
 		}
 		if( entity_rect.top < rect.top )
 		{
-			e.DisplaceBy( { 0.0f,rect.top - entity_rect.top } );
+			d.y = rect.top - entity_rect.top;
 		}
 		else if( entity_rect.bottom > rect.bottom )
 		{
-			e.DisplaceBy( { 0.0f,rect.bottom - entity_rect.bottom } );
+			d.y = rect.bottom - entity_rect.bottom;
 		}
+		return d;
 	}
 	const RectF& GetRect() const
 	{
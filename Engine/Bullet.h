@@ -1,52 +1,165 @@
 #pragma once
 
 #include "Vec2.h"
+#include "Rect.h"
 #include "Animation.h"
 #include "SpriteEffect.h"
 #include "Codex.h"
+#include "Sound.h"
+#include <vector>
+#include <algorithm>
 
-class Bullet
+// all the fireballs in flight, one slot in each array per bullet (structure of arrays)
+// storage for capacity bullets is set aside up front, firing and removing bullets
+// never touches the heap after that (when it is full the oldest bullet makes way)
+// slots are in firing order starting at the oldest, which is slot 0 until the store
+// fills up, after that each shot overwrites the oldest and the start moves on one
+// (so indices are slots, not firing order)
+class BulletStore
 {
 public:
-	Bullet( const Vec2& pos,const Vec2& dir )
+	// hitbox dimensions
+	static constexpr float hitbox_halfwidth = 4.0f;
+	static constexpr float hitbox_halfheight = 4.0f;
+	// bullet speed
+	static constexpr float speed = 300.0f;
+public:
+	BulletStore( int capacity )
 		:
-		bullet_animation( 0,0,8,8,4,Codex<Surface>::Retrieve( L"Images\\fireball.bmp" ),0.1f ),
-		pos( pos ),
-		vel( dir * speed )
+		capacity( capacity )
+	{
+		positions.reserve( capacity );
+		velocities.reserve( capacity );
+		animations.reserve( capacity );
+		// load the shared stuff now instead of in the middle of the first shot
+		GetClip();
+		GetSpawnSound();
+	}
+	void Spawn( const Vec2& pos,const Vec2& dir )
 	{
+		if( GetCount() == capacity )
+		{
+			// recycle the oldest in place
+			positions[oldest] = pos;
+			velocities[oldest] = dir * speed;
+			animations[oldest] = {};
+			oldest = (oldest + 1) % capacity;
+		}
+		else
+		{
+			positions.push_back( pos );
+			velocities.push_back( dir * speed );
+			animations.emplace_back();
+		}
 		// play fireball sound on fireball creation
-		Codex<Sound>::Retrieve( L"Sounds\\fball.wav" )->Play( 0.75f,0.4f );
+		GetSpawnSound()->Play( 0.75f,0.4f );
+	}
+	int GetCount() const
+	{
+		return int( positions.size() );
+	}
+	const Vec2& GetPos( int i ) const
+	{
+		return positions[i];
 	}
-	void Draw( Graphics& gfx ) const
+	RectF GetHitbox( int i ) const
 	{
-		// calculate drawing base
-		const auto draw_pos = pos + draw_offset;
-		// draw the bullet
-		bullet_animation.Draw( (Vei2)draw_pos,gfx );
+		return RectF::FromCenter( positions[i],hitbox_halfwidth,hitbox_halfheight );
 	}
 	void Update( float dt )
 	{
-		pos += vel * dt;
-		bullet_animation.Update( dt );
+		for( int i = 0; i < GetCount(); i++ )
+		{
+			positions[i] += velocities[i] * dt;
+		}
+		const AnimationClip& clip = GetClip();
+		for( auto& a : animations )
+		{
+			a.Update( clip,dt );
+		}
 	}
-	const Vec2& GetPos() const
+	void Draw( RenderQueue& rq ) const
 	{
-		return pos;
+		const AnimationClip& clip = GetClip();
+		for( int i = 0; i < GetCount(); i++ )
+		{
+			// depth sort on base position
+			rq.SetSortKey( RenderQueue::Layer::Entities,int( positions[i].y ) );
+			// calculate drawing base
+			const Vei2 draw_pos = { int( positions[i].x + draw_offset_x ),int( positions[i].y + draw_offset_y ) };
+			// draw the bullet
+			clip.Draw( animations[i].GetFrame(),draw_pos,rq );
+		}
 	}
-	RectF GetHitbox() const
+	// drops every bullet i that remove( i ) is true for, in one compaction pass
+	// (order of the rest is kept, remove sees each index before anything moves into it)
+	template<typename Pred>
+	void RemoveIf( Pred remove )
 	{
-		return RectF::FromCenter( pos,hitbox_halfwidth,hitbox_halfheight );
+		int nKept = 0;
+		// kept bullets in the slots before the oldest (the newest ones once the store wrapped)
+		int nKeptBeforeOldest = 0;
+		for( int i = 0; i < GetCount(); i++ )
+		{
+			if( remove( i ) )
+			{
+				continue;
+			}
+			if( i < oldest )
+			{
+				nKeptBeforeOldest++;
+			}
+			if( nKept != i )
+			{
+				positions[nKept] = positions[i];
+				velocities[nKept] = velocities[i];
+				animations[nKept] = animations[i];
+			}
+			nKept++;
+		}
+		if( nKept == GetCount() )
+		{
+			return;
+		}
+		positions.resize( nKept );
+		velocities.resize( nKept );
+		animations.resize( nKept );
+		// no longer full, so new bullets go on the end again: rotate the oldest back to slot 0
+		if( nKeptBeforeOldest != 0 )
+		{
+			std::rotate( positions.begin(),positions.begin() + nKeptBeforeOldest,positions.end() );
+			std::rotate( velocities.begin(),velocities.begin() + nKeptBeforeOldest,velocities.end() );
+			std::rotate( animations.begin(),animations.begin() + nKeptBeforeOldest,animations.end() );
+		}
+		oldest = 0;
+	}
+	// bytes one bullet takes up across the arrays (capacity of these is reserved up front)
+	static constexpr size_t GetSlotBytes()
+	{
+		return sizeof( decltype( positions )::value_type ) + sizeof( decltype( velocities )::value_type ) +
+			sizeof( decltype( animations )::value_type );
+	}
+private:
+	// fireball frames (shared by every bullet)
+	static const AnimationClip& GetClip()
+	{
+		static const AnimationClip clip( 0,0,8,8,4,Codex<Surface>::Retrieve( L"Images\\fireball.bmp" ),0.1f );
+		return clip;
+	}
+	static const Sound* GetSpawnSound()
+	{
+		static const Sound* const pSound = Codex<Sound>::Retrieve( L"Sounds\\fball.wav" );
+		return pSound;
 	}
 private:
-	Animation bullet_animation;
-	Vec2 pos;
-	// hitbox dimensions
-	float hitbox_halfwidth = 4.0f;
-	float hitbox_halfheight = 4.0f;
-	// bullet speed
-	float speed = 300.0f;
 	// this value give the offset from the actual base of the
 	// character to its drawing base
-	Vec2 draw_offset = { -4.0f,-4.0f };
-	Vec2 vel = { 0.0f,0.0f };
-};
\ No newline at end of file
+	static constexpr float draw_offset_x = -4.0f;
+	static constexpr float draw_offset_y = -4.0f;
+	int capacity;
+	// slot of the oldest bullet (only ever not 0 while the store is full)
+	int oldest = 0;
+	std::vector<Vec2> positions;
+	std::vector<Vec2> velocities;
+	std::vector<AnimationCursor> animations;
+};
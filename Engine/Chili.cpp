@@ -7,19 +7,25 @@ Chili::Chili( const Vec2& pos )
 	:
 	pos( pos )
 {
-	const auto pLegsSurface = Codex<Surface>::Retrieve( L"Images\\legs-skinny.bmp" );
 	// walking animation
-	animations.emplace_back( Animation( 32,0,32,33,9,pLegsSurface,0.09f ) );
+	animations.emplace_back( GetLegsClip( AnimationSequence::Walking ) );
 	// standing animation
-	animations.emplace_back( Animation( 0,0,32,33,1,pLegsSurface,10000.0f ) );
+	animations.emplace_back( GetLegsClip( AnimationSequence::Standing ) );
+	// chili is drawn mirrored whenever he turns around, make those copies now
+	// instead of in the middle of the first frame he does
+	headSprite.GetMirrored();
+	GetLegsClip( AnimationSequence::Walking ).PrepareMirrored();
+	GetLegsClip( AnimationSequence::Standing ).PrepareMirrored();
 }
 
-void Chili::Draw( Graphics& gfx ) const
+void Chili::Draw( RenderQueue& rq ) const
 {
-	dec.DrawChili( gfx );
+	// depth sort on base position (legs and head share the key)
+	rq.SetSortKey( RenderQueue::Layer::Entities,int( pos.y ) );
+	dec.DrawChili( rq );
 }
 
-void Chili::HandleInput( Keyboard& kbd,Mouse& mouse,const World& world )
+void Chili::HandleInput( Keyboard& kbd,Mouse& mouse,const World& /*world*/ )
 {
 	// process mouse messages while any remain
 	while( !mouse.IsEmpty() )
@@ -103,7 +109,7 @@ void Chili::ProcessBullet( World& world )
 	if( isFiring )
 	{
 		isFiring = false;
-		world.SpawnBullet( { bulletSpawnPos,bulletDir } );
+		world.SpawnBullet( bulletSpawnPos,bulletDir );
 	}
 }
 
@@ -144,6 +150,15 @@ void Chili::DisplaceBy( const Vec2& d )
 	pos += d;
 }
 
+const AnimationClip& Chili::GetLegsClip( AnimationSequence seq )
+{
+	// compiled on first use, shared by every chili
+	static const Surface* const pLegsSurface = Codex<Surface>::Retrieve( L"Images\\legs-skinny.bmp" );
+	static const AnimationClip walking( 32,0,32,33,9,pLegsSurface,0.09f );
+	static const AnimationClip standing( 0,0,32,33,1,pLegsSurface,10000.0f );
+	return seq == AnimationSequence::Walking ? walking : standing;
+}
+
 Chili::DamageEffectController::DamageEffectController( Chili& parent )
 	:
 	parent( parent )
@@ -163,7 +178,7 @@ void Chili::DamageEffectController::Update( float dt )
 	}
 }
 
-void Chili::DamageEffectController::DrawChili( Graphics& gfx ) const
+void Chili::DamageEffectController::DrawChili( RenderQueue& rq ) const
 {
 	// calculate drawing base
 	const auto draw_pos = parent.pos + parent.draw_offset;
@@ -178,10 +193,10 @@ void Chili::DamageEffectController::DrawChili( Graphics& gfx ) const
 		{
 			// draw legs first (they are behind head)
 			parent.animations[(int)parent.iCurSequence].DrawColor(
-				legspos,gfx,Colors::Red,parent.facingRight );
+				legspos,rq,Colors::Red,parent.facingRight );
 			// draw head
-			gfx.DrawSprite( int( draw_pos.x ),int( draw_pos.y ),*parent.pHeadSurface,
-				SpriteEffect::Substitution{ Colors::Magenta,Colors::Red },
+			rq.DrawSprite( int( draw_pos.x ),int( draw_pos.y ),parent.headSprite,
+				SpriteEffect::Fill{ Colors::Red },
 				parent.facingRight
 			);
 		}
@@ -193,10 +208,10 @@ void Chili::DamageEffectController::DrawChili( Graphics& gfx ) const
 			if( int( time / blinkHalfPeriod ) % 2 != 0 )
 			{
 				// draw legs first (they are behind head)
-				parent.animations[(int)parent.iCurSequence].Draw( legspos,gfx,parent.facingRight );
+				parent.animations[(int)parent.iCurSequence].Draw( legspos,rq,parent.facingRight );
 				// draw head
-				gfx.DrawSprite( int( draw_pos.x ),int( draw_pos.y ),*parent.pHeadSurface,
-					SpriteEffect::Chroma{ Colors::Magenta },
+				rq.DrawSprite( int( draw_pos.x ),int( draw_pos.y ),parent.headSprite,
+					SpriteEffect::Copy{},
 					parent.facingRight
 				);
 			}
@@ -206,10 +221,10 @@ void Chili::DamageEffectController::DrawChili( Graphics& gfx ) const
 	else
 	{
 		// draw legs first (they are behind head)
-		parent.animations[(int)parent.iCurSequence].Draw( legspos,gfx,parent.facingRight );
+		parent.animations[(int)parent.iCurSequence].Draw( legspos,rq,parent.facingRight );
 		// draw head
-		gfx.DrawSprite( int( draw_pos.x ),int( draw_pos.y ),*parent.pHeadSurface,
-			SpriteEffect::Chroma{ Colors::Magenta },
+		rq.DrawSprite( int( draw_pos.x ),int( draw_pos.y ),parent.headSprite,
+			SpriteEffect::Copy{},
 			parent.facingRight
 		);
 	}
@@ -17,7 +17,7 @@ private:
 		// update damage effect time
 		void Update( float dt );
 		// draw chili based on damage effect state
-		void DrawChili( Graphics& gfx ) const;
+		void DrawChili( RenderQueue& rq ) const;
 		// activate damage effect
 		void Activate();
 		bool IsActive() const;
@@ -35,9 +35,12 @@ private:
 		Standing,
 		Count
 	};
+public:
+	// draws Draw records at most (legs and head)
+	static constexpr int maxDraws = 2;
 public:
 	Chili( const Vec2& pos );
-	void Draw( Graphics& gfx ) const;
+	void Draw( RenderQueue& rq ) const;
 	// process input (can cause spawn of bullet, which is a little B.S.)
 	void HandleInput( class Keyboard& kbd,class Mouse& mouse,const class World& world );
 	void Update( class World& world,float dt );
@@ -49,8 +52,12 @@ public:
 private:
 	void SetDirection( const Vec2& dir );
 	void ProcessBullet( World& world );
+	// leg animation frames for each sequence
+	static const AnimationClip& GetLegsClip( AnimationSequence seq );
 private:
 	const Surface* pHeadSurface = Codex<Surface>::Retrieve( L"Images\\chilihead.bmp" );
+	// head compiled to opaque runs (magenta is the chroma)
+	CompiledSprite headSprite = { *pHeadSurface,Colors::Magenta };
 	const SoundEffect* pHurtSfx = Codex<SoundEffect>::Retrieve( L"Sounds\\chili_hurt.sfx" );
 	Vec2 pos;
 	// this flag is set during input processing to indicate a bullet should
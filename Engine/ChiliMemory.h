@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+// allocate memory aligned to the given boundary (power of 2)
+// must be released with aligned_free
+inline void* aligned_malloc( size_t size,size_t alignment )
+{
+#ifdef _MSC_VER
+	return _aligned_malloc( size,alignment );
+#else
+	void* p = nullptr;
+	if( posix_memalign( &p,alignment < sizeof( void* ) ? sizeof( void* ) : alignment,size ) != 0 )
+	{
+		return nullptr;
+	}
+	return p;
+#endif
+}
+
+inline void aligned_free( void* p )
+{
+#ifdef _MSC_VER
+	_aligned_free( p );
+#else
+	free( p );
+#endif
+}
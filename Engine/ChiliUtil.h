@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
+#include <cstddef>
 
 // remove an element from a vector
 // messes up the order of elements
@@ -19,12 +21,12 @@ inline void remove_element( std::vector<T>& vec,size_t index )
 // Acc is a functor used to access the search keys in the elements
 template<class Iter,typename T,typename Acc>
 auto binary_find( Iter begin,Iter end,const T& val,
-				  Acc acc = []( const Iter::value_type& obj ) 
-				  ->const Iter::value_type& { return obj; } )
+				  Acc acc = []( const typename Iter::value_type& obj ) 
+				  ->const typename Iter::value_type& { return obj; } )
 {
 	// Finds the lower bound in at most log(last - first) + 1 comparisons
 	const auto i = std::lower_bound( begin,end,val,
-		[acc]( const Iter::value_type& lhs,const T& rhs )
+		[acc]( const typename Iter::value_type& lhs,const T& rhs )
 		{
 			return acc( lhs ) < rhs;
 		}
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <vector>
-#include "resource.h"
 #include "ChiliUtil.h"
 #include <algorithm>
 #include <string>
@@ -30,6 +29,22 @@ public:
 	{
 		return Get()._Retrieve( key );
 	}
+	// true if key is in the codex (does not load anything)
+	static bool Contains( const std::wstring& key )
+	{
+		return Get()._Contains( key );
+	}
+	// add a resource that was created elsewhere (codex takes ownership)
+	// if key is already in the codex the existing resource is kept and false is returned
+	static bool Insert( const std::wstring& key,const T* pResource )
+	{
+		return Get()._Insert( key,pResource );
+	}
+	// delete a single resource (pointers to it become invalid)
+	static void Remove( const std::wstring& key )
+	{
+		Get()._Remove( key );
+	}
 	// remove all entries from codex
 	static void Purge()
 	{
@@ -47,13 +62,7 @@ private:
 	// retrieve a ptr to resource based on string (load if not exist)
 	const T* _Retrieve( const std::wstring& key )
 	{
-		// find position of resource OR where resource should be (with bin search)
-		auto i = std::lower_bound( entries.begin(),entries.end(),key,
-			[]( const Entry& e,const std::wstring& key )
-			{
-				return e.key < key;
-			}
-		);
+		auto i = FindPos( key );
 		// if resource does not exist (i.e. i does not point to resource with right key)
 		// load, store in sorted pos in codex, and set i to point to it
 		if( i == entries.end() || i->key != key )
@@ -64,6 +73,41 @@ private:
 		// return ptr to resource in codex
 		return i->pResource;
 	}
+	// find position of resource OR where resource should be (with bin search)
+	typename std::vector<Entry>::iterator FindPos( const std::wstring& key )
+	{
+		return std::lower_bound( entries.begin(),entries.end(),key,
+			[]( const Entry& e,const std::wstring& key )
+			{
+				return e.key < key;
+			}
+		);
+	}
+	bool _Contains( const std::wstring& key )
+	{
+		auto i = FindPos( key );
+		return i != entries.end() && i->key == key;
+	}
+	bool _Insert( const std::wstring& key,const T* pResource )
+	{
+		auto i = FindPos( key );
+		if( i != entries.end() && i->key == key )
+		{
+			delete pResource;
+			return false;
+		}
+		entries.emplace( i,key,pResource );
+		return true;
+	}
+	void _Remove( const std::wstring& key )
+	{
+		auto i = FindPos( key );
+		if( i != entries.end() && i->key == key )
+		{
+			delete i->pResource;
+			entries.erase( i );
+		}
+	}
 	// remove all entries from codex
 	void _Purge()
 	{
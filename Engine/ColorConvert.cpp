@@ -0,0 +1,284 @@
+#include "ColorConvert.h"
+#include "KernelRegistry.h"
+#include <algorithm>
+
+#ifdef CHILI_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+using ColorConvert::Order;
+
+namespace
+{
+	typedef void( *InPlaceKernel )( Color*,int );
+	typedef void( *SwizzleKernel )( const unsigned char*,Color*,int,Order );
+
+	void PremultiplyScalar( Color* p,int n )
+	{
+		for( int i = 0; i < n; i++ )
+		{
+			const Color pix = p[i];
+			const unsigned int alpha = pix.GetA();
+			p[i] = Color(
+				pix.GetA(),
+				(unsigned char)((pix.GetR() * alpha) / 256u),
+				(unsigned char)((pix.GetG() * alpha) / 256u),
+				(unsigned char)((pix.GetB() * alpha) / 256u)
+			);
+		}
+	}
+
+	void UnpremultiplyScalar( Color* p,int n )
+	{
+		for( int i = 0; i < n; i++ )
+		{
+			const Color pix = p[i];
+			const unsigned int alpha = pix.GetA();
+			if( alpha == 0u )
+			{
+				p[i] = 0u;
+				continue;
+			}
+			p[i] = Color(
+				pix.GetA(),
+				(unsigned char)std::min( pix.GetR() * 256u / alpha,255u ),
+				(unsigned char)std::min( pix.GetG() * 256u / alpha,255u ),
+				(unsigned char)std::min( pix.GetB() * 256u / alpha,255u )
+			);
+		}
+	}
+
+	void SwizzleScalar( const unsigned char* pSrc,Color* pDst,int n,Order order )
+	{
+		const int sel[4] = { order.b,order.g,order.r,order.x };
+		for( int i = 0; i < n; i++,pSrc += 4 )
+		{
+			// gather the whole pixel before writing (pSrc may alias pDst)
+			unsigned int dword = 0u;
+			for( int c = 0; c < 4; c++ )
+			{
+				if( sel[c] != Order::Zero )
+				{
+					dword |= (unsigned int)pSrc[sel[c]] << (8 * c);
+				}
+			}
+			pDst[i] = dword;
+		}
+	}
+
+#ifdef CHILI_X86
+	// premultiplies 2 pixels widened to 8 x 16 bit (b,g,r,a,b,g,r,a)
+	// c * a fits in 16 bits, so the low half of the multiply is the whole product
+	CHILI_TARGET_SSE2 __m128i PremultiplyWideSSE2( __m128i px )
+	{
+		__m128i alpha = _mm_shufflelo_epi16( px,_MM_SHUFFLE( 3,3,3,3 ) );
+		alpha = _mm_shufflehi_epi16( alpha,_MM_SHUFFLE( 3,3,3,3 ) );
+		return _mm_srli_epi16( _mm_mullo_epi16( px,alpha ),8 );
+	}
+
+	CHILI_TARGET_SSE2 void PremultiplySSE2( Color* p,int n )
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32( int( 0xFF000000u ) );
+		int i = 0;
+		for( ; i + 4 <= n; i += 4 )
+		{
+			__m128i* const pPix = reinterpret_cast<__m128i*>( p + i );
+			const __m128i src = _mm_loadu_si128( pPix );
+			const __m128i rgb = _mm_packus_epi16(
+				PremultiplyWideSSE2( _mm_unpacklo_epi8( src,zero ) ),
+				PremultiplyWideSSE2( _mm_unpackhi_epi8( src,zero ) ) );
+			// alpha channel came out as a * a / 256, put the original back
+			_mm_storeu_si128( pPix,_mm_or_si128(
+				_mm_andnot_si128( alphaMask,rgb ),
+				_mm_and_si128( alphaMask,src ) ) );
+		}
+		PremultiplyScalar( p + i,n - i );
+	}
+
+	// unpremultiplies 1 pixel widened to 4 x 32 bit (b,g,r,a)
+	// the float divide is exact enough that truncating it matches the integer divide
+	// (a == 0 lanes divide by zero and are cleared after)
+	CHILI_TARGET_SSE2 __m128i UnpremultiplyWideSSE2( __m128i px )
+	{
+		const __m128i alpha = _mm_shuffle_epi32( px,_MM_SHUFFLE( 3,3,3,3 ) );
+		const __m128 q = _mm_div_ps( _mm_cvtepi32_ps( _mm_slli_epi32( px,8 ) ),_mm_cvtepi32_ps( alpha ) );
+		return _mm_andnot_si128( _mm_cmpeq_epi32( alpha,_mm_setzero_si128() ),_mm_cvttps_epi32( q ) );
+	}
+
+	CHILI_TARGET_SSE2 void UnpremultiplySSE2( Color* p,int n )
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32( int( 0xFF000000u ) );
+		int i = 0;
+		for( ; i + 4 <= n; i += 4 )
+		{
+			__m128i* const pPix = reinterpret_cast<__m128i*>( p + i );
+			const __m128i src = _mm_loadu_si128( pPix );
+			const __m128i lo = _mm_unpacklo_epi8( src,zero );
+			const __m128i hi = _mm_unpackhi_epi8( src,zero );
+			// saturating packs do the clamp to 255
+			const __m128i rgb = _mm_packus_epi16(
+				_mm_packs_epi32(
+					UnpremultiplyWideSSE2( _mm_unpacklo_epi16( lo,zero ) ),
+					UnpremultiplyWideSSE2( _mm_unpackhi_epi16( lo,zero ) ) ),
+				_mm_packs_epi32(
+					UnpremultiplyWideSSE2( _mm_unpacklo_epi16( hi,zero ) ),
+					UnpremultiplyWideSSE2( _mm_unpackhi_epi16( hi,zero ) ) ) );
+			_mm_storeu_si128( pPix,_mm_or_si128(
+				_mm_andnot_si128( alphaMask,rgb ),
+				_mm_and_si128( alphaMask,src ) ) );
+		}
+		UnpremultiplyScalar( p + i,n - i );
+	}
+
+	// no byte shuffle in sse2, each channel is shifted into place separately
+	CHILI_TARGET_SSE2 void SwizzleSSE2( const unsigned char* pSrc,Color* pDst,int n,Order order )
+	{
+		const int sel[4] = { order.b,order.g,order.r,order.x };
+		const __m128i byteMask = _mm_set1_epi32( 0xFF );
+		__m128i srcShift[4];
+		__m128i dstShift[4];
+		for( int c = 0; c < 4; c++ )
+		{
+			srcShift[c] = _mm_cvtsi32_si128( 8 * std::max( sel[c],0 ) );
+			dstShift[c] = _mm_cvtsi32_si128( 8 * c );
+		}
+		int i = 0;
+		for( ; i + 4 <= n; i += 4 )
+		{
+			const __m128i src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc + 4 * i ) );
+			__m128i out = _mm_setzero_si128();
+			for( int c = 0; c < 4; c++ )
+			{
+				if( sel[c] != Order::Zero )
+				{
+					const __m128i channel = _mm_and_si128( _mm_srl_epi32( src,srcShift[c] ),byteMask );
+					out = _mm_or_si128( out,_mm_sll_epi32( channel,dstShift[c] ) );
+				}
+			}
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + i ),out );
+		}
+		SwizzleScalar( pSrc + 4 * i,pDst + i,n - i,order );
+	}
+
+	// same as the sse2 versions, 2 pixels per 128 bit lane (all ops stay in lane)
+	CHILI_TARGET_AVX2 __m256i PremultiplyWideAVX2( __m256i px )
+	{
+		__m256i alpha = _mm256_shufflelo_epi16( px,_MM_SHUFFLE( 3,3,3,3 ) );
+		alpha = _mm256_shufflehi_epi16( alpha,_MM_SHUFFLE( 3,3,3,3 ) );
+		return _mm256_srli_epi16( _mm256_mullo_epi16( px,alpha ),8 );
+	}
+
+	CHILI_TARGET_AVX2 void PremultiplyAVX2( Color* p,int n )
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i alphaMask = _mm256_set1_epi32( int( 0xFF000000u ) );
+		int i = 0;
+		for( ; i + 8 <= n; i += 8 )
+		{
+			__m256i* const pPix = reinterpret_cast<__m256i*>( p + i );
+			const __m256i src = _mm256_loadu_si256( pPix );
+			const __m256i rgb = _mm256_packus_epi16(
+				PremultiplyWideAVX2( _mm256_unpacklo_epi8( src,zero ) ),
+				PremultiplyWideAVX2( _mm256_unpackhi_epi8( src,zero ) ) );
+			_mm256_storeu_si256( pPix,_mm256_blendv_epi8( rgb,src,alphaMask ) );
+		}
+		PremultiplyScalar( p + i,n - i );
+	}
+
+	CHILI_TARGET_AVX2 __m256i UnpremultiplyWideAVX2( __m256i px )
+	{
+		const __m256i alpha = _mm256_shuffle_epi32( px,_MM_SHUFFLE( 3,3,3,3 ) );
+		const __m256 q = _mm256_div_ps( _mm256_cvtepi32_ps( _mm256_slli_epi32( px,8 ) ),_mm256_cvtepi32_ps( alpha ) );
+		return _mm256_andnot_si256( _mm256_cmpeq_epi32( alpha,_mm256_setzero_si256() ),_mm256_cvttps_epi32( q ) );
+	}
+
+	CHILI_TARGET_AVX2 void UnpremultiplyAVX2( Color* p,int n )
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i alphaMask = _mm256_set1_epi32( int( 0xFF000000u ) );
+		int i = 0;
+		for( ; i + 8 <= n; i += 8 )
+		{
+			__m256i* const pPix = reinterpret_cast<__m256i*>( p + i );
+			const __m256i src = _mm256_loadu_si256( pPix );
+			const __m256i lo = _mm256_unpacklo_epi8( src,zero );
+			const __m256i hi = _mm256_unpackhi_epi8( src,zero );
+			const __m256i rgb = _mm256_packus_epi16(
+				_mm256_packs_epi32(
+					UnpremultiplyWideAVX2( _mm256_unpacklo_epi16( lo,zero ) ),
+					UnpremultiplyWideAVX2( _mm256_unpackhi_epi16( lo,zero ) ) ),
+				_mm256_packs_epi32(
+					UnpremultiplyWideAVX2( _mm256_unpacklo_epi16( hi,zero ) ),
+					UnpremultiplyWideAVX2( _mm256_unpackhi_epi16( hi,zero ) ) ) );
+			_mm256_storeu_si256( pPix,_mm256_blendv_epi8( rgb,src,alphaMask ) );
+		}
+		UnpremultiplyScalar( p + i,n - i );
+	}
+
+	// one byte shuffle does the whole job (index with the high bit set gives 0)
+	CHILI_TARGET_AVX2 void SwizzleAVX2( const unsigned char* pSrc,Color* pDst,int n,Order order )
+	{
+		const int sel[4] = { order.b,order.g,order.r,order.x };
+		char indices[32];
+		for( int px = 0; px < 8; px++ )
+		{
+			for( int c = 0; c < 4; c++ )
+			{
+				indices[px * 4 + c] = sel[c] == Order::Zero ? char( 0x80 ) : char( (px % 4) * 4 + sel[c] );
+			}
+		}
+		const __m256i shuffle = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( indices ) );
+		int i = 0;
+		for( ; i + 8 <= n; i += 8 )
+		{
+			const __m256i src = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pSrc + 4 * i ) );
+			_mm256_storeu_si256( reinterpret_cast<__m256i*>( pDst + i ),_mm256_shuffle_epi8( src,shuffle ) );
+		}
+		SwizzleScalar( pSrc + 4 * i,pDst + i,n - i,order );
+	}
+#endif
+
+	// kernels are bound at startup, and again if the tier limit changes (see KernelRegistry)
+	// (no avx-512 versions, those tiers fall back to avx2)
+	KernelSlot<InPlaceKernel> premultiplySlot(
+		PremultiplyScalar,
+		CHILI_SSE2_KERNEL( PremultiplySSE2 ),
+		CHILI_AVX2_KERNEL( PremultiplyAVX2 ),
+		nullptr
+	);
+	KernelSlot<InPlaceKernel> unpremultiplySlot(
+		UnpremultiplyScalar,
+		CHILI_SSE2_KERNEL( UnpremultiplySSE2 ),
+		CHILI_AVX2_KERNEL( UnpremultiplyAVX2 ),
+		nullptr
+	);
+	KernelSlot<SwizzleKernel> swizzleSlot(
+		SwizzleScalar,
+		CHILI_SSE2_KERNEL( SwizzleSSE2 ),
+		CHILI_AVX2_KERNEL( SwizzleAVX2 ),
+		nullptr
+	);
+}
+
+namespace ColorConvert
+{
+	void Premultiply( Color* p,int n )
+	{
+		premultiplySlot.Get()( p,n );
+	}
+	void Unpremultiply( Color* p,int n )
+	{
+		unpremultiplySlot.Get()( p,n );
+	}
+	void Swizzle( const void* pSrc,Color* pDst,int n,Order order )
+	{
+		swizzleSlot.Get()( static_cast<const unsigned char*>( pSrc ),pDst,n,order );
+	}
+	void RgbaToBgrx( const unsigned char* pSrc,Color* pDst,int n,bool keepAlpha )
+	{
+		swizzleSlot.Get()( pSrc,pDst,n,{ 2,1,0,keepAlpha ? 3 : Order::Zero } );
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Colors.h"
+
+// bulk pixel format conversions used when loading and baking surfaces
+// the best implementation (avx2 / sse2 / scalar) is bound by KernelRegistry
+// all versions produce exactly the same output
+namespace ColorConvert
+{
+	// where each channel of the destination Color comes from: the index (0-3) of the
+	// byte in the source pixel, or Zero to clear the channel
+	struct Order
+	{
+		static constexpr int Zero = -1;
+		int b;
+		int g;
+		int r;
+		int x;
+	};
+
+	// premultiplies r,g,b by alpha in place, c = c * a / 256 (alpha is kept)
+	// this is the format expected by SpriteEffect::AlphaBlendBaked
+	void Premultiply( Color* p,int n );
+	// undoes Premultiply as far as the rounding allows, c = min( c * 256 / a,255 )
+	// pixels with a == 0 come out black (alpha is kept)
+	void Unpremultiply( Color* p,int n );
+	// rearranges 4 byte pixels (any byte alignment) into Colors
+	// pSrc may be the same memory as pDst
+	void Swizzle( const void* pSrc,Color* pDst,int n,Order order );
+	// r,g,b,a byte pixels (png order) to Colors, x = a if keepAlpha, otherwise 0
+	void RgbaToBgrx( const unsigned char* pSrc,Color* pDst,int n,bool keepAlpha );
+}
@@ -26,10 +26,8 @@ public:
 	unsigned int dword;
 public:
 	constexpr Color() : dword() {}
-	constexpr Color( const Color& col )
-		:
-		dword( col.dword )
-	{}
+	// defaulted copy keeps Color trivially copyable (safe for memcpy of pixel rows)
+	constexpr Color( const Color& col ) = default;
 	constexpr Color( unsigned int dw )
 		:
 		dword( dw )
@@ -46,11 +44,7 @@ public:
 		:
 		Color( (x << 24u) | col.dword )
 	{}
-	Color& operator =( Color color )
-	{
-		dword = color.dword;
-		return *this;
-	}
+	Color& operator =( const Color& color ) = default;
 	bool operator==( const Color& rhs ) const
 	{
 		return dword == rhs.dword;
@@ -0,0 +1,118 @@
+#include "CompiledSprite.h"
+#include <cassert>
+#include <iterator>
+
+CompiledSprite::CompiledSprite( const Surface& s,const RectI& srcRect,Color chroma )
+	:
+	width( srcRect.GetWidth() ),
+	height( srcRect.GetHeight() )
+{
+	assert( srcRect.left >= 0 );
+	assert( srcRect.right <= s.GetWidth() );
+	assert( srcRect.top >= 0 );
+	assert( srcRect.bottom <= s.GetHeight() );
+
+	rowStarts.reserve( height + 1 );
+	for( int y = 0; y < height; y++ )
+	{
+		rowStarts.push_back( int( runs.size() ) );
+		const Color* const pRow = s.GetRowPtr( srcRect.top + y ) + srcRect.left;
+		int x = 0;
+		while( x < width )
+		{
+			// skip over transparent pixels
+			while( x < width && pRow[x] == chroma )
+			{
+				x++;
+			}
+			if( x == width )
+			{
+				break;
+			}
+			// collect run of opaque pixels
+			const int start = x;
+			while( x < width && pRow[x] != chroma )
+			{
+				x++;
+			}
+			runs.push_back( { start,x - start,int( pixels.size() ) } );
+			pixels.insert( pixels.end(),pRow + start,pRow + x );
+		}
+	}
+	rowStarts.push_back( int( runs.size() ) );
+}
+
+CompiledSprite::CompiledSprite( const Surface& s,Color chroma )
+	:
+	CompiledSprite( s,s.GetRect(),chroma )
+{}
+
+CompiledSprite::CompiledSprite( int width,int height )
+	:
+	width( width ),
+	height( height )
+{}
+
+int CompiledSprite::GetWidth() const
+{
+	return width;
+}
+
+int CompiledSprite::GetHeight() const
+{
+	return height;
+}
+
+RectI CompiledSprite::GetRect() const
+{
+	return{ 0,width,0,height };
+}
+
+const CompiledSprite::Run* CompiledSprite::GetRunsBegin( int y ) const
+{
+	assert( y >= 0 );
+	assert( y < height );
+	return runs.data() + rowStarts[y];
+}
+
+const CompiledSprite::Run* CompiledSprite::GetRunsEnd( int y ) const
+{
+	assert( y >= 0 );
+	assert( y < height );
+	return runs.data() + rowStarts[y + 1];
+}
+
+const Color* CompiledSprite::GetPixels() const
+{
+	return pixels.data();
+}
+
+const CompiledSprite* CompiledSprite::GetMirrored() const
+{
+	const size_t bytes = sizeof( Color ) * pixels.size() + sizeof( Run ) * runs.size() +
+		sizeof( int ) * rowStarts.size();
+	return mirror.Get( bytes,[this]()
+	{
+		CompiledSprite m( width,height );
+		m.runs.reserve( runs.size() );
+		m.rowStarts.reserve( rowStarts.size() );
+		m.pixels.reserve( pixels.size() );
+		for( int y = 0; y < height; y++ )
+		{
+			m.rowStarts.push_back( int( m.runs.size() ) );
+			// last run of the row becomes the first, with its pixels reversed
+			for( auto pRun = GetRunsEnd( y ); pRun != GetRunsBegin( y ); )
+			{
+				--pRun;
+				const Color* const pSrc = pixels.data() + pRun->offset;
+				m.runs.push_back( { width - pRun->x - pRun->length,pRun->length,int( m.pixels.size() ) } );
+				m.pixels.insert( m.pixels.end(),
+					std::reverse_iterator<const Color*>( pSrc + pRun->length ),
+					std::reverse_iterator<const Color*>( pSrc )
+				);
+			}
+		}
+		m.rowStarts.push_back( int( m.runs.size() ) );
+		return m;
+	} );
+}
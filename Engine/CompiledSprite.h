@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Surface.h"
+#include "Colors.h"
+#include "Rect.h"
+#include "MirrorCache.h"
+#include <vector>
+
+// sprite that is preprocessed at load time into runs of opaque pixels for each row
+// drawing it never has to test pixels against the chroma key, it just hands the
+// opaque runs to the effect (so SpriteEffect::Copy becomes a memcpy per run)
+class CompiledSprite
+{
+public:
+	// horizontal run of opaque pixels in a row
+	class Run
+	{
+	public:
+		// start of run relative to the left edge of the sprite
+		int x;
+		int length;
+		// index of first pixel of the run in the packed pixel array
+		int offset;
+	};
+public:
+	// compile the srcRect region of surface s, pixels matching chroma are dropped
+	CompiledSprite( const Surface& s,const RectI& srcRect,Color chroma );
+	CompiledSprite( const Surface& s,Color chroma );
+	int GetWidth() const;
+	int GetHeight() const;
+	RectI GetRect() const;
+	// runs of row y (sorted left to right) are [GetRunsBegin( y ),GetRunsEnd( y ))
+	const Run* GetRunsBegin( int y ) const;
+	const Run* GetRunsEnd( int y ) const;
+	// opaque pixels of all runs packed back to back
+	const Color* GetPixels() const;
+	// horizontally flipped version, built on first use
+	// (nullptr if it doesn't fit in the MirrorBudget)
+	const CompiledSprite* GetMirrored() const;
+private:
+	// empty sprite (for building the mirrored version)
+	CompiledSprite( int width,int height );
+private:
+	int width;
+	int height;
+	std::vector<Run> runs;
+	// index of first run of each row (height + 1 entries, last one is runs.size())
+	std::vector<int> rowStarts;
+	std::vector<Color> pixels;
+	MirrorCache<CompiledSprite> mirror;
+};
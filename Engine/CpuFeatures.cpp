@@ -0,0 +1,67 @@
+#include "CpuFeatures.h"
+
+#ifdef CHILI_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+#ifdef CHILI_X86
+	// fills regs with eax,ebx,ecx,edx for the given cpuid leaf/subleaf
+	void QueryCpuid( unsigned int leaf,unsigned int subleaf,unsigned int regs[4] )
+	{
+#ifdef _MSC_VER
+		int r[4];
+		__cpuidex( r,int( leaf ),int( subleaf ) );
+		for( int i = 0; i < 4; i++ )
+		{
+			regs[i] = (unsigned int)r[i];
+		}
+#else
+		__cpuid_count( leaf,subleaf,regs[0],regs[1],regs[2],regs[3] );
+#endif
+	}
+	// reads the extended control register (which register states the os saves)
+	unsigned long long ReadXCR0()
+	{
+#ifdef _MSC_VER
+		return _xgetbv( 0 );
+#else
+		unsigned int lo,hi;
+		__asm__ __volatile__( "xgetbv" : "=a"( lo ),"=d"( hi ) : "c"( 0 ) );
+		return ((unsigned long long)hi << 32) | lo;
+#endif
+	}
+#endif
+}
+
+CpuFeatures::CpuFeatures()
+{
+#ifdef CHILI_X86
+	unsigned int regs[4];
+	QueryCpuid( 0u,0u,regs );
+	const unsigned int maxLeaf = regs[0];
+	if( maxLeaf < 1u )
+	{
+		return;
+	}
+	QueryCpuid( 1u,0u,regs );
+	sse2 = (regs[3] & (1u << 26)) != 0u;
+	// avx needs the os to save ymm state as well as the cpu supporting it
+	const bool osxsave = (regs[2] & (1u << 27)) != 0u;
+	const bool avx = (regs[2] & (1u << 28)) != 0u;
+	const bool ymmSaved = osxsave && (ReadXCR0() & 0x6u) == 0x6u;
+	if( maxLeaf >= 7u && avx && ymmSaved )
+	{
+		QueryCpuid( 7u,0u,regs );
+		avx2 = (regs[1] & (1u << 5)) != 0u;
+		// avx-512 also needs the os to save the opmask and upper zmm state
+		const bool zmmSaved = (ReadXCR0() & 0xE6u) == 0xE6u;
+		avx512 = zmmSaved && (regs[1] & (1u << 16)) != 0u && (regs[1] & (1u << 30)) != 0u;
+	}
+#endif
+}
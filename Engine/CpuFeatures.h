@@ -0,0 +1,55 @@
+#pragma once
+
+// are we on an x86/x64 target (SIMD kernels are only built there)
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __i386__ ) || defined( __x86_64__ )
+#define CHILI_X86
+#endif
+
+// msvc lets us use any intrinsic anywhere, gcc/clang need the instruction set
+// enabled per function (we don't want to build the whole program for avx2)
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#define CHILI_TARGET_SSE2
+#define CHILI_TARGET_AVX2
+#define CHILI_TARGET_AVX512
+#else
+#define CHILI_TARGET_SSE2 __attribute__(( target( "sse2" ) ))
+#define CHILI_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#define CHILI_TARGET_AVX512 __attribute__(( target( "avx512f,avx512bw" ) ))
+#endif
+
+// avx-512 intrinsics only exist from vs2017 15.3 on (v140 builds just go without those kernels)
+#if defined( CHILI_X86 ) && (!defined( _MSC_VER ) || defined( __clang__ ) || _MSC_VER >= 1911)
+#define CHILI_AVX512
+#endif
+
+// detects which SIMD instruction sets the cpu (and os) support
+// detection runs once on first query
+class CpuFeatures
+{
+public:
+	static bool HasSSE2()
+	{
+		return Get().sse2;
+	}
+	static bool HasAVX2()
+	{
+		return Get().avx2;
+	}
+	// avx-512 foundation + byte/word instructions (what the 512 bit kernels use)
+	static bool HasAVX512()
+	{
+		return Get().avx512;
+	}
+private:
+	CpuFeatures();
+	// gets the singleton instance (detects features on first call)
+	static const CpuFeatures& Get()
+	{
+		static const CpuFeatures features;
+		return features;
+	}
+private:
+	bool sse2 = false;
+	bool avx2 = false;
+	bool avx512 = false;
+};
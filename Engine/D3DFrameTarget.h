@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ChiliWin.h"
+#include <d3d11.h>
+#include <wrl.h>
+#include "ChiliException.h"
+#include "FrameTarget.h"
+
+// presents frames to a window by uploading the frame into a texture (see Upload)
+// and drawing it as a fullscreen quad with D3D11
+class D3DFrameTarget : public FrameTarget
+{
+public:
+	// how the frame gets to the gpu
+	enum class Upload
+	{
+		// Graphics draws into its sysbuffer, Present copies it into a mapped dynamic texture
+		Copy,
+		// Graphics draws straight into one of two mapped staging textures (lent by
+		// AcquireFrame), Present only has the gpu copy it into the texture that gets drawn
+		// while the cpu draws the next frame into the other one
+		// (not the default yet, it still has to be checked on real hardware)
+		Direct
+	};
+public:
+	class Exception : public ChiliException
+	{
+	public:
+		Exception( HRESULT hr,const std::wstring& note,const wchar_t* file,unsigned int line );
+		std::wstring GetErrorName() const;
+		std::wstring GetErrorDescription() const;
+		virtual std::wstring GetFullMessage() const override;
+		virtual std::wstring GetExceptionType() const override;
+	private:
+		HRESULT hr;
+	};
+private:
+	// vertex format for the framebuffer fullscreen textured quad
+	struct FSQVertex
+	{
+		float x,y,z;		// position
+		float u,v;			// texcoords
+	};
+public:
+	D3DFrameTarget( class HWNDKey& key,Upload upload = Upload::Copy );
+	D3DFrameTarget( const D3DFrameTarget& ) = delete;
+	D3DFrameTarget& operator=( const D3DFrameTarget& ) = delete;
+	~D3DFrameTarget();
+	// looks for -upload=<copy|direct> in the command line (see MainWindow::GetArgs)
+	// returns false if there is an -upload argument that names no mode (upload is left as is)
+	static bool ParseArgs( const std::wstring& args,Upload& upload );
+	// maps the next staging texture in Direct mode (nullptr in Copy mode)
+	Color* AcquireFrame( int width,int height,int& pitch ) override;
+	void Present( const Color* pFrame,int width,int height,int pitch ) override;
+	// whole frame read and written to the mapped texture when it had to be copied, 0 when
+	// it was drawn in place
+	size_t GetPresentTraffic() const override;
+private:
+	Microsoft::WRL::ComPtr<IDXGISwapChain>				pSwapChain;
+	Microsoft::WRL::ComPtr<ID3D11Device>				pDevice;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext>			pImmediateContext;
+	Microsoft::WRL::ComPtr<ID3D11RenderTargetView>		pRenderTargetView;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D>				pSysBufferTexture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>	pSysBufferTextureView;
+	Microsoft::WRL::ComPtr<ID3D11PixelShader>			pPixelShader;
+	Microsoft::WRL::ComPtr<ID3D11VertexShader>			pVertexShader;
+	Microsoft::WRL::ComPtr<ID3D11Buffer>				pVertexBuffer;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout>			pInputLayout;
+	Microsoft::WRL::ComPtr<ID3D11SamplerState>			pSamplerState;
+	D3D11_MAPPED_SUBRESOURCE							mappedSysBufferTexture;
+	// Direct mode: the cpu side textures Graphics draws into, alternating every frame
+	Microsoft::WRL::ComPtr<ID3D11Texture2D>				pStagingTextures[2];
+	int													iStaging = 0;
+	bool												stagingMapped = false;
+	Upload												upload;
+	size_t												presentTraffic = 0u;
+};
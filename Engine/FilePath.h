@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <algorithm>
+
+// asset paths in the game are written windows style (wide, with backslashes)
+// this turns them into a narrow path the c library can open on other platforms
+// (only for ascii paths, same as the narrowing done for error messages)
+inline std::string ToNarrowPath( const std::wstring& filename )
+{
+	std::string path( filename.begin(),filename.end() );
+#ifndef _WIN32
+	std::replace( path.begin(),path.end(),'\\','/' );
+#endif
+	return path;
+}
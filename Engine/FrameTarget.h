@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Colors.h"
+#include <cstddef>
+
+// a frame target is where Graphics sends the finished frame at the end
+// of every frame (the D3D window, or just memory when running headless)
+class FrameTarget
+{
+public:
+	virtual ~FrameTarget() = default;
+	// called by Graphics::BeginFrame, targets that can lend the memory the frame is
+	// drawn into return it here (rows pitch pixels apart) and Present has nothing to copy
+	// nullptr (the default) means Graphics draws into its own sysbuffer
+	virtual Color* AcquireFrame( int /*width*/,int /*height*/,int& /*pitch*/ )
+	{
+		return nullptr;
+	}
+	// called by Graphics::EndFrame with the completed frame (rows pitch pixels apart)
+	// pFrame is either the lent memory or the sysbuffer
+	virtual void Present( const Color* pFrame,int width,int height,int pitch ) = 0;
+	// bytes of memory traffic the last Present caused (for the bandwidth stats in Graphics)
+	virtual size_t GetPresentTraffic() const
+	{
+		return 0;
+	}
+};
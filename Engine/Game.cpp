@@ -20,20 +20,54 @@
  ******************************************************************************************/
 #include "MainWindow.h"
 #include "Game.h"
+#include "D3DFrameTarget.h"
 #include "ChiliUtil.h"
+#include "AllocationCounter.h"
 #include <algorithm>
+#include <cassert>
 #include <functional>
+#include <string>
 
 
+namespace
+{
+	// Copy unless -upload=direct is given (Direct skips the present copy, but stays opt-in
+	// until it has been checked on real hardware)
+	D3DFrameTarget::Upload GetUpload( const MainWindow& wnd )
+	{
+		D3DFrameTarget::Upload upload = D3DFrameTarget::Upload::Copy;
+		D3DFrameTarget::ParseArgs( wnd.GetArgs(),upload );
+		return upload;
+	}
+}
+
 Game::Game( MainWindow& wnd )
 	:
 	wnd( wnd ),
-	gfx( wnd ),
+	gfx( std::make_unique<D3DFrameTarget>( wnd,GetUpload( wnd ) ) ),
+	// every sprite sheet the world retrieves from the codex
+	atlas( {
+		L"Images\\floor5.bmp",
+		L"Images\\poo.bmp",
+		L"Images\\fireball.bmp",
+		L"Images\\legs-skinny.bmp",
+		L"Images\\chilihead.bmp"
+	} ),
 	world( gfx.GetScreenRect() )
-{}
+{
+	rq.Reserve( world.GetMaxDrawCount() );
+#ifndef NDEBUG
+	const std::wstring report = L"atlas: " + std::to_wstring( atlas.GetPageCount() ) + L" page(s), " +
+		std::to_wstring( atlas.GetPageBytes() / 1024u ) + L" KiB, " +
+		std::to_wstring( int( atlas.GetOccupancy() * 100.0f ) ) + L"% occupied\n";
+	OutputDebugStringW( report.c_str() );
+#endif
+}
 
 void Game::Go()
 {
+	// underlayer paints the whole screen, so clearing it first would be wasted bandwidth
+	gfx.BeginFrame( Colors::Black,world.Covers( gfx.GetScreenRect() ) );
 	UpdateModel();
 	ComposeFrame();
 	gfx.EndFrame();
@@ -46,11 +80,18 @@ void Game::UpdateModel()
 #else
 	const auto dt = 1.0f / 60.0f;
 #endif
+	// the world keeps all its entities in preallocated stores, so a frame of
+	// game logic should never hit the heap (checked in debug builds)
+	// (frees aren't checked, reading input events can release blocks of the mouse queue)
+	const size_t nAllocs = AllocationCounter::GetCount();
 	world.HandleInput( wnd.kbd,wnd.mouse );
 	world.Update( dt );
+	assert( AllocationCounter::GetCount() == nAllocs );
 }
 
 void Game::ComposeFrame()
 {
-	world.Draw( gfx );
+	// record the frame, then rasterize it across the band threads
+	world.Draw( rq );
+	rq.Render( gfx );
 }
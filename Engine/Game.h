@@ -23,6 +23,8 @@
 #include "Keyboard.h"
 #include "Mouse.h"
 #include "Graphics.h"
+#include "RenderQueue.h"
+#include "SurfaceAtlas.h"
 #include "FrameTimer.h"
 #include "World.h"
 
@@ -39,6 +41,9 @@ private:
 private:
 	MainWindow& wnd;
 	Graphics gfx;
+	RenderQueue rq;
 	FrameTimer ft;
+	// must come before world (it puts the sprites in the codex before world loads them)
+	SurfaceAtlas atlas;
 	World world;
 };
\ No newline at end of file
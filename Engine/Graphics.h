@@ -19,46 +19,58 @@
 *	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
 ******************************************************************************************/
 #pragma once
-#include "ChiliWin.h"
-#include <d3d11.h>
-#include <wrl.h>
-#include "ChiliException.h"
 #include "Colors.h"
 #include "Surface.h"
+#include "CompiledSprite.h"
 #include "Rect.h"
+#include "FrameTarget.h"
+#include <memory>
+#include <algorithm>
 #include <cassert>
+#include <type_traits>
+
+// effects that write every source pixel unchanged (no keying, no blending) declare
+// static constexpr bool isOpaqueCopy = true, DrawSprite picks that up at compile time
+template<typename E,typename = void>
+struct IsOpaqueCopy : std::false_type
+{};
+template<typename E>
+struct IsOpaqueCopy<E,decltype( void( E::isOpaqueCopy ) )> : std::integral_constant<bool,E::isOpaqueCopy>
+{};
 
 class Graphics
 {
 public:
-	class Exception : public ChiliException
+	// sysbuffer memory traffic of the last frame outside of drawing
+	// (what the clear wrote, and what present read from the sysbuffer and wrote out)
+	class FrameTraffic
 	{
 	public:
-		Exception( HRESULT hr,const std::wstring& note,const wchar_t* file,unsigned int line );
-		std::wstring GetErrorName() const;
-		std::wstring GetErrorDescription() const;
-		virtual std::wstring GetFullMessage() const override;
-		virtual std::wstring GetExceptionType() const override;
-	private:
-		HRESULT hr;
-	};
-private:
-	// vertex format for the framebuffer fullscreen textured quad
-	struct FSQVertex
-	{
-		float x,y,z;		// position
-		float u,v;			// texcoords
+		size_t GetTotal() const
+		{
+			return clearBytes + presentBytes;
+		}
+	public:
+		size_t clearBytes = 0;
+		size_t presentBytes = 0;
 	};
 public:
-	Graphics( class HWNDKey& key );
+	// the frame target decides where finished frames go
+	// (D3DFrameTarget for the window, MemoryFrameTarget for headless runs)
+	// targets that lend their own memory get drawn into directly between BeginFrame
+	// and EndFrame (see FrameTarget::AcquireFrame), otherwise drawing goes to the sysbuffer
+	Graphics( std::unique_ptr<FrameTarget> pTarget );
 	Graphics( const Graphics& ) = delete;
 	Graphics& operator=( const Graphics& ) = delete;
 	void EndFrame();
-	void BeginFrame( Color bg = Colors::Black );
+	// picks the frame memory and clears it to bg
+	// screenCovered skips the clear when the first thing drawn covers every pixel anyway
+	void BeginFrame( Color bg = Colors::Black,bool screenCovered = false );
+	const FrameTraffic& GetLastFrameTraffic() const;
 	Color GetPixel( int x,int y ) const;
 	void PutPixel( int x,int y,int r,int g,int b )
 	{
-		PutPixel( x,y,{ unsigned char( r ),unsigned char( g ),unsigned char( b ) } );
+		PutPixel( x,y,{ (unsigned char)r,(unsigned char)g,(unsigned char)b } );
 	}
 	void PutPixel( int x,int y,Color c );
 	// draw a thin line rect [top-left:bottom-right)
@@ -115,6 +127,7 @@ public:
 	{
 		DrawSprite( x,y,srcRect,GetScreenRect(),s,effect,reversed );
 	}
+	// effect is invoked once per clipped row span (see SpriteEffect.h for the contract)
 	template<typename E>
 	void DrawSprite( int x,int y,RectI srcRect,const RectI& clip,const Surface& s,E effect,bool reversed = false )
 	{
@@ -145,22 +158,37 @@ public:
 			{
 				srcRect.bottom -= y + srcRect.GetHeight() - clip.bottom;
 			}
+			// nothing left to draw after clipping
+			if( srcRect.IsDegenerate() )
+			{
+				return;
+			}
+			// hand the effect one row span at a time
 			for( int sy = srcRect.top; sy < srcRect.bottom; sy++ )
 			{
-				for( int sx = srcRect.left; sx < srcRect.right; sx++ )
-				{
-					effect(
-						// no mirroring
-						s.GetPixel( sx,sy ),
-						x + sx - srcRect.left,
-						y + sy - srcRect.top,
-						*this
-					);
-				}
+				const int yDest = y + sy - srcRect.top;
+				effect(
+					// no mirroring, walk source forward
+					s.GetRowPtr( sy ) + srcRect.left,1,
+					GetRowPtr( yDest ) + x,
+					srcRect.GetWidth(),
+					yDest
+				);
 			}
 		}
 		else
 		{
+			// mirrored copy can be read forwards like any other sprite
+			// (opaque copies reverse in register just as fast, so they skip building one)
+			if( const Surface* pMirrored = IsOpaqueCopy<E>::value ? nullptr : s.GetMirrored() )
+			{
+				const int width = s.GetWidth();
+				DrawSprite( x,y,{ width - srcRect.right,width - srcRect.left,srcRect.top,srcRect.bottom },
+					clip,*pMirrored,effect,false
+				);
+				return;
+			}
+			// otherwise read the source backwards
 			if( x < clip.left )
 			{
 				srcRect.right -= clip.left - x;
@@ -179,18 +207,85 @@ public:
 			{
 				srcRect.bottom -= y + srcRect.GetHeight() - clip.bottom;
 			}
-			const int xOffset = srcRect.left + srcRect.right - 1;
+			if( srcRect.IsDegenerate() )
+			{
+				return;
+			}
 			for( int sy = srcRect.top; sy < srcRect.bottom; sy++ )
 			{
-				for( int sx = srcRect.left; sx < srcRect.right; sx++ )
+				const int yDest = y + sy - srcRect.top;
+				effect(
+					// mirror in x, leftmost dest pixel comes from rightmost src pixel
+					s.GetRowPtr( sy ) + srcRect.right - 1,-1,
+					GetRowPtr( yDest ) + x,
+					srcRect.GetWidth(),
+					yDest
+				);
+			}
+		}
+	}
+	template<typename E>
+	void DrawSprite( int x,int y,const CompiledSprite& s,E effect,bool reversed = false )
+	{
+		DrawSprite( x,y,GetScreenRect(),s,effect,reversed );
+	}
+	// compiled sprites only hand the effect their opaque runs
+	// (transparent pixels were thrown away when the sprite was compiled)
+	template<typename E>
+	void DrawSprite( int x,int y,const RectI& clip,const CompiledSprite& s,E effect,bool reversed = false )
+	{
+		// runs of the mirrored copy can be read forwards
+		if( reversed && !IsOpaqueCopy<E>::value )
+		{
+			if( const CompiledSprite* pMirrored = s.GetMirrored() )
+			{
+				DrawSprite( x,y,clip,*pMirrored,effect,false );
+				return;
+			}
+		}
+		// clip rows
+		const int rowBegin = std::max( clip.top - y,0 );
+		const int rowEnd = std::min( clip.bottom - y,s.GetHeight() );
+		const Color* const pPixels = s.GetPixels();
+		const int width = s.GetWidth();
+		for( int sy = rowBegin; sy < rowEnd; sy++ )
+		{
+			const int yDest = y + sy;
+			Color* const pRow = GetRowPtr( yDest );
+			for( auto pRun = s.GetRunsBegin( sy ),end = s.GetRunsEnd( sy ); pRun != end; ++pRun )
+			{
+				int xDest;
+				int len = pRun->length;
+				const Color* pSrc;
+				int srcStep;
+				if( !reversed )
+				{
+					xDest = x + pRun->x;
+					pSrc = pPixels + pRun->offset;
+					srcStep = 1;
+				}
+				else
+				{
+					// mirror in x, leftmost dest pixel comes from last pixel of the run
+					xDest = x + width - pRun->x - len;
+					pSrc = pPixels + pRun->offset + len - 1;
+					srcStep = -1;
+				}
+				// clip run
+				if( xDest < clip.left )
+				{
+					const int skip = clip.left - xDest;
+					pSrc += skip * srcStep;
+					len -= skip;
+					xDest = clip.left;
+				}
+				if( xDest + len > clip.right )
 				{
-					effect(
-						// mirror in x
-						s.GetPixel( xOffset - sx,sy ),
-						x + sx - srcRect.left,
-						y + sy - srcRect.top,
-						*this
-					);
+					len = clip.right - xDest;
+				}
+				if( len > 0 )
+				{
+					effect( pSrc,srcStep,pRow + xDest,len,yDest );
 				}
 			}
 		}
@@ -198,19 +293,21 @@ public:
 
 	~Graphics();
 private:
-	Microsoft::WRL::ComPtr<IDXGISwapChain>				pSwapChain;
-	Microsoft::WRL::ComPtr<ID3D11Device>				pDevice;
-	Microsoft::WRL::ComPtr<ID3D11DeviceContext>			pImmediateContext;
-	Microsoft::WRL::ComPtr<ID3D11RenderTargetView>		pRenderTargetView;
-	Microsoft::WRL::ComPtr<ID3D11Texture2D>				pSysBufferTexture;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>	pSysBufferTextureView;
-	Microsoft::WRL::ComPtr<ID3D11PixelShader>			pPixelShader;
-	Microsoft::WRL::ComPtr<ID3D11VertexShader>			pVertexShader;
-	Microsoft::WRL::ComPtr<ID3D11Buffer>				pVertexBuffer;
-	Microsoft::WRL::ComPtr<ID3D11InputLayout>			pInputLayout;
-	Microsoft::WRL::ComPtr<ID3D11SamplerState>			pSamplerState;
-	D3D11_MAPPED_SUBRESOURCE							mappedSysBufferTexture;
+	Color* GetRowPtr( int y )
+	{
+		assert( y >= 0 );
+		assert( y < int( Graphics::ScreenHeight ) );
+		return pFrame + framePitch * y;
+	}
+private:
+	std::unique_ptr<FrameTarget>						pTarget;
 	Color*                                              pSysBuffer = nullptr;
+	// what is being drawn into (the sysbuffer, or memory lent by the target)
+	Color*												pFrame = nullptr;
+	int													framePitch = ScreenWidth;
+	// traffic of the frame in progress, and of the last finished one
+	FrameTraffic										traffic;
+	FrameTraffic										lastTraffic;
 public:
 	static constexpr int ScreenWidth = 800;
 	static constexpr int ScreenHeight = 600;
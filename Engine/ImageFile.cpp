@@ -0,0 +1,691 @@
+#include "ImageFile.h"
+#include "FilePath.h"
+#include "ColorConvert.h"
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+
+namespace
+{
+	typedef std::vector<unsigned char> Bytes;
+
+	using ImageFile::maxDimension;
+
+	std::string Narrow( const std::wstring& s )
+	{
+		return std::string( s.begin(),s.end() );
+	}
+
+	[[noreturn]] void Fail( const std::wstring& filename,const std::string& what )
+	{
+		throw std::runtime_error( "ImageFile::Load " + what + ": " + Narrow( filename ) );
+	}
+
+	Bytes ReadFile( const std::wstring& filename )
+	{
+#ifdef _MSC_VER
+		std::ifstream file( filename,std::ios::binary );
+#else
+		std::ifstream file( ToNarrowPath( filename ),std::ios::binary );
+#endif
+		if( !file )
+		{
+			Fail( filename,"failed to open file" );
+		}
+		return Bytes( std::istreambuf_iterator<char>( file ),std::istreambuf_iterator<char>() );
+	}
+
+	unsigned int ReadLE16( const unsigned char* p )
+	{
+		return p[0] | (p[1] << 8u);
+	}
+
+	unsigned int ReadLE32( const unsigned char* p )
+	{
+		return p[0] | (p[1] << 8u) | (p[2] << 16u) | (unsigned int)(p[3] << 24u);
+	}
+
+	unsigned int ReadBE32( const unsigned char* p )
+	{
+		return (unsigned int)(p[0] << 24u) | (p[1] << 16u) | (p[2] << 8u) | p[3];
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// bmp
+
+	Surface DecodeBmp( const Bytes& file,const std::wstring& filename )
+	{
+		// file header (14) + at least the basic info header (40)
+		if( file.size() < 54 )
+		{
+			Fail( filename,"truncated bmp header" );
+		}
+		const unsigned char* const p = file.data();
+		const unsigned int dataOffset = ReadLE32( p + 10 );
+		const unsigned int headerSize = ReadLE32( p + 14 );
+		const int width = int( ReadLE32( p + 18 ) );
+		const unsigned int rawHeight = ReadLE32( p + 22 );
+		const unsigned int bitCount = ReadLE16( p + 28 );
+		const unsigned int compression = ReadLE32( p + 30 );
+		// negative height means rows are stored top to bottom
+		// (negated as unsigned, so INT_MIN can't overflow and just fails the bounds check)
+		const bool bottomUp = int32_t( rawHeight ) > 0;
+		const unsigned int absHeight = bottomUp ? rawHeight : 0u - rawHeight;
+		const int height = absHeight > unsigned( maxDimension ) ? -1 : int( absHeight );
+		if( width <= 0 || height <= 0 || width > maxDimension || height > maxDimension )
+		{
+			Fail( filename,"bad bmp dimensions" );
+		}
+		if( bitCount != 24 && bitCount != 32 )
+		{
+			Fail( filename,"unsupported bmp bit depth (only 24 and 32 bit)" );
+		}
+		// BI_RGB, or BI_BITFIELDS with the standard 32 bit layout
+		bool hasAlpha = false;
+		if( compression == 3 && bitCount == 32 )
+		{
+			if( file.size() < 66 ||
+				ReadLE32( p + 54 ) != 0x00FF0000u ||
+				ReadLE32( p + 58 ) != 0x0000FF00u ||
+				ReadLE32( p + 62 ) != 0x000000FFu )
+			{
+				Fail( filename,"unsupported bmp channel masks" );
+			}
+			// alpha mask only exists in v4 and later headers
+			hasAlpha = headerSize >= 56 && file.size() >= 70 && ReadLE32( p + 66 ) == 0xFF000000u;
+		}
+		else if( compression != 0 )
+		{
+			Fail( filename,"compressed bmp not supported" );
+		}
+		// rows are padded to 4 bytes
+		const size_t stride = (size_t( width ) * bitCount / 8u + 3u) & ~size_t( 3u );
+		if( dataOffset > file.size() || stride * height > file.size() - dataOffset )
+		{
+			Fail( filename,"truncated bmp pixel data" );
+		}
+
+		Surface surf( width,height );
+		for( int y = 0; y < height; y++ )
+		{
+			const unsigned char* pSrc = p + dataOffset + stride * (bottomUp ? height - 1 - y : y);
+			Color* const pDst = surf.GetRowPtr( y );
+			if( bitCount == 24 )
+			{
+				for( int x = 0; x < width; x++,pSrc += 3 )
+				{
+					// stored as b,g,r
+					pDst[x] = { pSrc[2],pSrc[1],pSrc[0] };
+				}
+			}
+			else
+			{
+				// stored as b,g,r,a which is exactly the layout of Color
+				ColorConvert::Swizzle( pSrc,pDst,width,{ 0,1,2,hasAlpha ? 3 : ColorConvert::Order::Zero } );
+			}
+		}
+		return surf;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// inflate (zlib / deflate decompression for png)
+
+	class Inflater
+	{
+	private:
+		// canonical huffman code decoded with a single lookup table
+		// indexed by the next maxLength bits of input (codes are stored bit reversed)
+		class Huffman
+		{
+		public:
+			void Build( const unsigned char* lengths,int nSymbols )
+			{
+				int counts[16] = {};
+				maxLength = 0;
+				for( int i = 0; i < nSymbols; i++ )
+				{
+					counts[lengths[i]]++;
+					maxLength = std::max( maxLength,int( lengths[i] ) );
+				}
+				// entries left at 0 are invalid codes (incomplete code sets are allowed)
+				table.assign( size_t( 1 ) << maxLength,0 );
+				if( maxLength == 0 )
+				{
+					return;
+				}
+				// first code of each length
+				counts[0] = 0;
+				int nextCode[16] = {};
+				int code = 0;
+				for( int len = 1; len < 16; len++ )
+				{
+					code = (code + counts[len - 1]) << 1;
+					nextCode[len] = code;
+				}
+				for( int sym = 0; sym < nSymbols; sym++ )
+				{
+					const int len = lengths[sym];
+					if( len == 0 )
+					{
+						continue;
+					}
+					const int c = nextCode[len]++;
+					if( c >= (1 << len) )
+					{
+						throw std::runtime_error( "oversubscribed huffman code" );
+					}
+					// reverse code bits (deflate packs huffman codes msb first)
+					int rev = 0;
+					for( int i = 0; i < len; i++ )
+					{
+						rev |= ((c >> i) & 1) << (len - 1 - i);
+					}
+					const uint16_t entry = uint16_t( (sym << 4) | len );
+					for( size_t i = rev; i < table.size(); i += size_t( 1 ) << len )
+					{
+						table[i] = entry;
+					}
+				}
+			}
+		public:
+			// low 4 bits are code length, the rest is the symbol
+			std::vector<uint16_t> table;
+			int maxLength = 0;
+		};
+	public:
+		Inflater( const unsigned char* pData,size_t size )
+			:
+			pData( pData ),
+			size( size )
+		{}
+		// decompress a zlib stream that should come to expectedSize bytes
+		// (streams that go past that are rejected instead of decompressed)
+		Bytes InflateZlib( size_t expectedSize )
+		{
+			limit = expectedSize;
+			const unsigned int cmf = GetBits( 8 );
+			const unsigned int flg = GetBits( 8 );
+			if( (cmf & 0x0Fu) != 8u || ((cmf << 8u) | flg) % 31u != 0u || (flg & 0x20u) != 0u )
+			{
+				throw std::runtime_error( "bad zlib header" );
+			}
+			Bytes out;
+			// the size is only what the header claims, reserve no more than deflate
+			// could possibly expand the input to
+			out.reserve( size < expectedSize / maxDeflateRatio ? size * maxDeflateRatio : expectedSize );
+			bool last = false;
+			while( !last )
+			{
+				last = GetBits( 1 ) != 0;
+				switch( GetBits( 2 ) )
+				{
+				case 0:
+					Stored( out );
+					break;
+				case 1:
+					BuildFixed();
+					Compressed( out );
+					break;
+				case 2:
+					BuildDynamic();
+					Compressed( out );
+					break;
+				default:
+					throw std::runtime_error( "bad deflate block type" );
+				}
+			}
+			return out;
+		}
+	private:
+		void CheckRoom( const Bytes& out,size_t count ) const
+		{
+			if( count > limit - out.size() )
+			{
+				throw std::runtime_error( "more data than the image holds" );
+			}
+		}
+		void Refill()
+		{
+			while( bitCount <= 56 && pos < size )
+			{
+				bitBuf |= uint64_t( pData[pos++] ) << bitCount;
+				bitCount += 8;
+			}
+		}
+		unsigned int GetBits( int n )
+		{
+			if( n == 0 )
+			{
+				return 0u;
+			}
+			Refill();
+			if( bitCount < n )
+			{
+				throw std::runtime_error( "unexpected end of deflate stream" );
+			}
+			const unsigned int bits = (unsigned int)(bitBuf & ((uint64_t( 1 ) << n) - 1u));
+			bitBuf >>= n;
+			bitCount -= n;
+			return bits;
+		}
+		int Decode( const Huffman& h )
+		{
+			Refill();
+			// past the end of input the buffer reads as zeros, checked against bitCount below
+			const uint16_t entry = h.table.empty() ? 0 :
+				h.table[size_t( bitBuf & ((uint64_t( 1 ) << h.maxLength) - 1u) )];
+			const int len = entry & 0xF;
+			if( len == 0 || len > bitCount )
+			{
+				throw std::runtime_error( "bad huffman code in deflate stream" );
+			}
+			bitBuf >>= len;
+			bitCount -= len;
+			return entry >> 4;
+		}
+		void Stored( Bytes& out )
+		{
+			// skip to byte boundary
+			GetBits( bitCount & 7 );
+			const unsigned int len = GetBits( 16 );
+			const unsigned int nlen = GetBits( 16 );
+			if( (len ^ 0xFFFFu) != nlen )
+			{
+				throw std::runtime_error( "bad stored block length" );
+			}
+			CheckRoom( out,len );
+			for( unsigned int i = 0; i < len; i++ )
+			{
+				out.push_back( (unsigned char)GetBits( 8 ) );
+			}
+		}
+		void BuildFixed()
+		{
+			unsigned char lengths[288 + 30];
+			std::fill( lengths,lengths + 144,(unsigned char)8 );
+			std::fill( lengths + 144,lengths + 256,(unsigned char)9 );
+			std::fill( lengths + 256,lengths + 280,(unsigned char)7 );
+			std::fill( lengths + 280,lengths + 288,(unsigned char)8 );
+			std::fill( lengths + 288,lengths + 288 + 30,(unsigned char)5 );
+			litLen.Build( lengths,288 );
+			dist.Build( lengths + 288,30 );
+		}
+		void BuildDynamic()
+		{
+			static constexpr int order[19] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
+			const int nLitLen = int( GetBits( 5 ) ) + 257;
+			const int nDist = int( GetBits( 5 ) ) + 1;
+			const int nCodeLen = int( GetBits( 4 ) ) + 4;
+			unsigned char codeLenLengths[19] = {};
+			for( int i = 0; i < nCodeLen; i++ )
+			{
+				codeLenLengths[order[i]] = (unsigned char)GetBits( 3 );
+			}
+			Huffman codeLen;
+			codeLen.Build( codeLenLengths,19 );
+			// literal/length and distance code lengths are one run-length coded sequence
+			unsigned char lengths[288 + 32] = {};
+			int n = 0;
+			while( n < nLitLen + nDist )
+			{
+				const int sym = Decode( codeLen );
+				if( sym < 16 )
+				{
+					lengths[n++] = (unsigned char)sym;
+					continue;
+				}
+				int repeat;
+				unsigned char value = 0;
+				if( sym == 16 )
+				{
+					if( n == 0 )
+					{
+						throw std::runtime_error( "bad code length repeat" );
+					}
+					value = lengths[n - 1];
+					repeat = 3 + int( GetBits( 2 ) );
+				}
+				else if( sym == 17 )
+				{
+					repeat = 3 + int( GetBits( 3 ) );
+				}
+				else
+				{
+					repeat = 11 + int( GetBits( 7 ) );
+				}
+				if( n + repeat > nLitLen + nDist )
+				{
+					throw std::runtime_error( "bad code length repeat" );
+				}
+				std::fill( lengths + n,lengths + n + repeat,value );
+				n += repeat;
+			}
+			litLen.Build( lengths,nLitLen );
+			dist.Build( lengths + nLitLen,nDist );
+		}
+		void Compressed( Bytes& out )
+		{
+			static constexpr int lengthBase[29] = {
+				3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+			static constexpr int lengthExtra[29] = {
+				0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+			static constexpr int distBase[30] = {
+				1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,
+				1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+			static constexpr int distExtra[30] = {
+				0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+			while( true )
+			{
+				const int sym = Decode( litLen );
+				if( sym < 256 )
+				{
+					CheckRoom( out,1 );
+					out.push_back( (unsigned char)sym );
+				}
+				else if( sym == 256 )
+				{
+					return;
+				}
+				else
+				{
+					const int li = sym - 257;
+					if( li >= 29 )
+					{
+						throw std::runtime_error( "bad length code" );
+					}
+					const int len = lengthBase[li] + int( GetBits( lengthExtra[li] ) );
+					const int di = Decode( dist );
+					if( di >= 30 )
+					{
+						throw std::runtime_error( "bad distance code" );
+					}
+					const size_t d = size_t( distBase[di] ) + GetBits( distExtra[di] );
+					if( d > out.size() )
+					{
+						throw std::runtime_error( "distance too far back" );
+					}
+					CheckRoom( out,len );
+					// byte at a time, source and destination may overlap
+					size_t from = out.size() - d;
+					for( int i = 0; i < len; i++ )
+					{
+						out.push_back( out[from++] );
+					}
+				}
+			}
+		}
+	private:
+		// deflate can't expand its input more than about 1032:1
+		static constexpr size_t maxDeflateRatio = 1032u;
+		const unsigned char* pData;
+		size_t size;
+		size_t limit = 0;
+		size_t pos = 0;
+		uint64_t bitBuf = 0;
+		int bitCount = 0;
+		Huffman litLen;
+		Huffman dist;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// png
+
+	int Paeth( int a,int b,int c )
+	{
+		const int p = a + b - c;
+		const int pa = std::abs( p - a );
+		const int pb = std::abs( p - b );
+		const int pc = std::abs( p - c );
+		if( pa <= pb && pa <= pc )
+		{
+			return a;
+		}
+		return pb <= pc ? b : c;
+	}
+
+	// undo the png filter of one scanline in place (prev is the already unfiltered row above)
+	void Unfilter( int type,unsigned char* cur,const unsigned char* prev,size_t stride,size_t bpp )
+	{
+		switch( type )
+		{
+		case 0:
+			break;
+		case 1:
+			for( size_t i = bpp; i < stride; i++ )
+			{
+				cur[i] += cur[i - bpp];
+			}
+			break;
+		case 2:
+			for( size_t i = 0; i < stride; i++ )
+			{
+				cur[i] += prev[i];
+			}
+			break;
+		case 3:
+			for( size_t i = 0; i < stride; i++ )
+			{
+				const int left = i >= bpp ? cur[i - bpp] : 0;
+				cur[i] += (unsigned char)((left + prev[i]) / 2);
+			}
+			break;
+		case 4:
+			for( size_t i = 0; i < stride; i++ )
+			{
+				const int left = i >= bpp ? cur[i - bpp] : 0;
+				const int upLeft = i >= bpp ? prev[i - bpp] : 0;
+				cur[i] += (unsigned char)Paeth( left,prev[i],upLeft );
+			}
+			break;
+		default:
+			throw std::runtime_error( "bad png filter type" );
+		}
+	}
+
+	Surface DecodePng( const Bytes& file,const std::wstring& filename )
+	{
+		size_t pos = 8;
+		int width = 0;
+		int height = 0;
+		int bitDepth = 0;
+		int colorType = -1;
+		Bytes idat;
+		// palette colors have x = 0 unless there is a tRNS chunk
+		std::vector<Color> palette;
+		// walk chunks
+		while( true )
+		{
+			if( file.size() - pos < 12 )
+			{
+				Fail( filename,"truncated png" );
+			}
+			const unsigned int length = ReadBE32( &file[pos] );
+			const std::string type( file.begin() + pos + 4,file.begin() + pos + 8 );
+			const unsigned char* const pData = &file[pos + 8];
+			if( length > file.size() - pos - 12 )
+			{
+				Fail( filename,"truncated png chunk" );
+			}
+			if( type == "IHDR" )
+			{
+				if( length < 13 )
+				{
+					Fail( filename,"bad png header" );
+				}
+				width = int( ReadBE32( pData ) );
+				height = int( ReadBE32( pData + 4 ) );
+				bitDepth = pData[8];
+				colorType = pData[9];
+				if( pData[12] != 0 )
+				{
+					Fail( filename,"interlaced png not supported" );
+				}
+			}
+			else if( type == "PLTE" )
+			{
+				palette.clear();
+				for( unsigned int i = 0; i + 2 < length; i += 3 )
+				{
+					palette.push_back( { pData[i],pData[i + 1],pData[i + 2] } );
+				}
+			}
+			else if( type == "tRNS" && colorType == 3 )
+			{
+				// alpha for the first entries of the palette
+				for( unsigned int i = 0; i < length && i < palette.size(); i++ )
+				{
+					palette[i] = { palette[i],pData[i] };
+				}
+				for( size_t i = length; i < palette.size(); i++ )
+				{
+					palette[i] = { palette[i],255 };
+				}
+			}
+			else if( type == "IDAT" )
+			{
+				idat.insert( idat.end(),pData,pData + length );
+			}
+			else if( type == "IEND" )
+			{
+				break;
+			}
+			// skip data and crc
+			pos += 12 + length;
+		}
+		if( width <= 0 || height <= 0 || width > maxDimension || height > maxDimension )
+		{
+			Fail( filename,"bad png dimensions" );
+		}
+		int channels;
+		switch( colorType )
+		{
+		case 0: channels = 1; break;
+		case 2: channels = 3; break;
+		case 3: channels = 1; break;
+		case 4: channels = 2; break;
+		case 6: channels = 4; break;
+		default: Fail( filename,"bad png color type" );
+		}
+		const bool validDepth = bitDepth == 8 || bitDepth == 16 ||
+			((colorType == 0 || colorType == 3) && (bitDepth == 1 || bitDepth == 2 || bitDepth == 4));
+		if( !validDepth )
+		{
+			Fail( filename,"bad png bit depth" );
+		}
+		if( colorType == 3 && palette.empty() )
+		{
+			Fail( filename,"png palette missing" );
+		}
+		// bytes per scanline and per pixel (at least 1, for filtering)
+		const size_t stride = (size_t( width ) * channels * bitDepth + 7u) / 8u;
+		const size_t bpp = std::max( size_t( channels * bitDepth / 8 ),size_t( 1 ) );
+		// filter byte + scanline for every row (can't overflow with the dimensions capped,
+		// but size_t is only 32 bits on x86 so check anyway)
+		if( stride + 1 > SIZE_MAX / size_t( height ) )
+		{
+			Fail( filename,"png too big" );
+		}
+		const size_t rawSize = (stride + 1) * height;
+
+		Bytes raw;
+		try
+		{
+			Inflater inflater( idat.data(),idat.size() );
+			raw = inflater.InflateZlib( rawSize );
+		}
+		catch( const std::runtime_error& e )
+		{
+			Fail( filename,std::string( "corrupt png data (" ) + e.what() + ")" );
+		}
+		if( raw.size() < rawSize )
+		{
+			Fail( filename,"png data too short" );
+		}
+
+		Surface surf( width,height );
+		// zero row above the first one
+		const Bytes zeros( stride,0 );
+		const unsigned char* prev = zeros.data();
+		// 16 bit samples are big endian, so the high byte comes first
+		const size_t sampleStep = bitDepth == 16 ? 2 : 1;
+		for( int y = 0; y < height; y++ )
+		{
+			unsigned char* const cur = &raw[y * (stride + 1) + 1];
+			Unfilter( cur[-1],cur,prev,stride,bpp );
+			Color* const pDst = surf.GetRowPtr( y );
+			if( bitDepth < 8 )
+			{
+				// packed gray or palette indices, leftmost pixel in the high bits
+				const int perByte = 8 / bitDepth;
+				const int mask = (1 << bitDepth) - 1;
+				for( int x = 0; x < width; x++ )
+				{
+					const int shift = 8 - bitDepth * (x % perByte + 1);
+					const int v = (cur[x / perByte] >> shift) & mask;
+					if( colorType == 3 )
+					{
+						pDst[x] = v < int( palette.size() ) ? palette[v] : Colors::Black;
+					}
+					else
+					{
+						// scale gray level up to 8 bits
+						const unsigned char g = (unsigned char)(v * 255 / mask);
+						pDst[x] = { g,g,g };
+					}
+				}
+			}
+			else if( colorType == 6 && bitDepth == 8 )
+			{
+				// the common case for sprites, converted in bulk
+				ColorConvert::RgbaToBgrx( cur,pDst,width,true );
+			}
+			else
+			{
+				const unsigned char* s = cur;
+				for( int x = 0; x < width; x++ )
+				{
+					switch( colorType )
+					{
+					case 0:
+						pDst[x] = { s[0],s[0],s[0] };
+						break;
+					case 2:
+						pDst[x] = { s[0],s[sampleStep],s[2 * sampleStep] };
+						break;
+					case 3:
+						pDst[x] = s[0] < palette.size() ? palette[s[0]] : Colors::Black;
+						break;
+					case 4:
+						pDst[x] = { s[sampleStep],s[0],s[0],s[0] };
+						break;
+					case 6:
+						pDst[x] = { s[3 * sampleStep],s[0],s[sampleStep],s[2 * sampleStep] };
+						break;
+					}
+					s += channels * sampleStep;
+				}
+			}
+			prev = cur;
+		}
+		return surf;
+	}
+}
+
+Surface ImageFile::Load( const std::wstring& filename )
+{
+	const Bytes file = ReadFile( filename );
+	static const unsigned char pngSignature[8] = { 0x89,'P','N','G','\r','\n',0x1A,'\n' };
+	if( file.size() >= 8 && std::equal( pngSignature,pngSignature + 8,file.begin() ) )
+	{
+		return DecodePng( file,filename );
+	}
+	if( file.size() >= 2 && file[0] == 'B' && file[1] == 'M' )
+	{
+		return DecodeBmp( file,filename );
+	}
+	Fail( filename,"unknown image format" );
+}
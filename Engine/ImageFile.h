@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Surface.h"
+#include <string>
+
+// portable loader for the image formats the game ships (no gdiplus)
+//	bmp: uncompressed 24 and 32 bit (bottom-up or top-down)
+//	png: gray, rgb, palette, gray + alpha and rgba at any bit depth (non-interlaced)
+// pixels are decoded straight into the rows of the surface
+// formats with alpha keep it in the x channel, formats without get x = 0
+// throws std::runtime_error for missing files and anything it doesn't understand
+namespace ImageFile
+{
+	// largest width or height accepted (headers claiming more are treated as corrupt,
+	// so a tiny file can't make us allocate gigabytes)
+	constexpr int maxDimension = 16384;
+
+	Surface Load( const std::wstring& filename );
+}
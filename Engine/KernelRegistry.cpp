@@ -0,0 +1,137 @@
+#include "KernelRegistry.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace
+{
+	const char* const tierNames[int( SimdTier::Count )] = { "scalar","sse2","avx2","avx512" };
+
+	std::string ReadEnvironment( const char* name )
+	{
+#ifdef _MSC_VER
+		// getenv is deprecated (sdl checks) on msvc
+		char* pValue = nullptr;
+		size_t size = 0;
+		if( _dupenv_s( &pValue,&size,name ) != 0 || pValue == nullptr )
+		{
+			return {};
+		}
+		const std::string value( pValue );
+		free( pValue );
+		return value;
+#else
+		const char* const pValue = std::getenv( name );
+		return pValue != nullptr ? pValue : "";
+#endif
+	}
+}
+
+KernelRegistry::KernelRegistry()
+{
+	if( CpuFeatures::HasAVX512() )
+	{
+		supported = SimdTier::AVX512;
+	}
+	else if( CpuFeatures::HasAVX2() )
+	{
+		supported = SimdTier::AVX2;
+	}
+	else if( CpuFeatures::HasSSE2() )
+	{
+		supported = SimdTier::SSE2;
+	}
+	active = supported;
+	// environment override applies from the very first kernel bound
+	SimdTier limit;
+	if( ParseTier( ReadEnvironment( "CHILI_SIMD" ),limit ) )
+	{
+		active = std::min( limit,supported );
+	}
+}
+
+KernelRegistry& KernelRegistry::Get()
+{
+	static KernelRegistry registry;
+	return registry;
+}
+
+SimdTier KernelRegistry::GetSupportedTier()
+{
+	return Get().supported;
+}
+
+SimdTier KernelRegistry::GetActiveTier()
+{
+	KernelRegistry& r = Get();
+	std::lock_guard<std::mutex> lock( r.mutex );
+	return r.active;
+}
+
+void KernelRegistry::SetTierLimit( SimdTier limit )
+{
+	KernelRegistry& r = Get();
+	std::lock_guard<std::mutex> lock( r.mutex );
+	r.active = std::min( limit,r.supported );
+	for( auto pSlot : r.slots )
+	{
+		pSlot->Bind( r.active );
+	}
+}
+
+bool KernelRegistry::ApplyArgs( const std::wstring& args )
+{
+	static const std::wstring key = L"-simd=";
+	const auto pos = args.find( key );
+	if( pos == std::wstring::npos )
+	{
+		return true;
+	}
+	// value runs to the next space (tier names are plain ascii)
+	const auto begin = pos + key.size();
+	const auto end = std::min( args.find( L' ',begin ),args.size() );
+	std::string name;
+	for( auto i = begin; i < end; i++ )
+	{
+		name.push_back( char( args[i] ) );
+	}
+	SimdTier limit;
+	if( !ParseTier( name,limit ) )
+	{
+		return false;
+	}
+	SetTierLimit( limit );
+	return true;
+}
+
+const char* KernelRegistry::GetTierName( SimdTier tier )
+{
+	return tierNames[int( tier )];
+}
+
+bool KernelRegistry::ParseTier( const std::string& name,SimdTier& tier )
+{
+	std::string lower;
+	for( char c : name )
+	{
+		lower.push_back( char( std::tolower( (unsigned char)c ) ) );
+	}
+	for( int t = 0; t < int( SimdTier::Count ); t++ )
+	{
+		if( lower == tierNames[t] )
+		{
+			tier = SimdTier( t );
+			return true;
+		}
+	}
+	return false;
+}
+
+void KernelRegistry::Register( SlotBase& slot )
+{
+	KernelRegistry& r = Get();
+	std::lock_guard<std::mutex> lock( r.mutex );
+	r.slots.push_back( &slot );
+	slot.Bind( r.active );
+}
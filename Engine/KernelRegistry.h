@@ -0,0 +1,103 @@
+#pragma once
+
+#include "CpuFeatures.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// simd instruction set levels that kernels are written for (in increasing order)
+enum class SimdTier
+{
+	Scalar,
+	SSE2,
+	AVX2,
+	AVX512,
+	Count
+};
+
+// binds every registered kernel slot (see KernelSlot) to the best implementation
+// the cpu supports, at startup and again whenever the tier limit changes
+// the limit can be forced down for A/B benchmarking with the CHILI_SIMD environment
+// variable or a -simd=<tier> command line argument (scalar, sse2, avx2 or avx512)
+class KernelRegistry
+{
+public:
+	class SlotBase
+	{
+	public:
+		virtual ~SlotBase() = default;
+		// pick the best implementation at or below tier
+		virtual void Bind( SimdTier tier ) = 0;
+	};
+public:
+	// best tier the cpu (and os) can run
+	static SimdTier GetSupportedTier();
+	// tier kernels are bound to (the limit clamped to what is supported)
+	static SimdTier GetActiveTier();
+	// rebinds every slot, call before drawing starts (not while a frame is rendering)
+	static void SetTierLimit( SimdTier limit );
+	// looks for -simd=<tier> in the command line (see MainWindow::GetArgs)
+	// returns false if there is a -simd argument that names no tier
+	static bool ApplyArgs( const std::wstring& args );
+	static const char* GetTierName( SimdTier tier );
+	// case insensitive tier name, false if it names no tier
+	static bool ParseTier( const std::string& name,SimdTier& tier );
+	// slots register themselves on construction (they must be static, they never unregister)
+	static void Register( SlotBase& slot );
+private:
+	KernelRegistry();
+	static KernelRegistry& Get();
+private:
+	std::mutex mutex;
+	std::vector<SlotBase*> slots;
+	SimdTier supported = SimdTier::Scalar;
+	SimdTier active = SimdTier::Scalar;
+};
+
+// one kernel entry point with an implementation per tier (nullptr where there is none)
+// Get() returns the currently bound implementation
+template<typename Fn>
+class KernelSlot : public KernelRegistry::SlotBase
+{
+public:
+	KernelSlot( Fn scalar,Fn sse2,Fn avx2,Fn avx512 )
+		:
+		impls{ scalar,sse2,avx2,avx512 },
+		pActive( scalar )
+	{
+		KernelRegistry::Register( *this );
+	}
+	Fn Get() const
+	{
+		return pActive.load( std::memory_order_relaxed );
+	}
+	void Bind( SimdTier tier ) override
+	{
+		for( int t = int( tier ); t >= 0; t-- )
+		{
+			if( impls[t] != nullptr )
+			{
+				pActive.store( impls[t],std::memory_order_relaxed );
+				return;
+			}
+		}
+	}
+private:
+	Fn impls[int( SimdTier::Count )];
+	std::atomic<Fn> pActive;
+};
+
+// names a kernel for a KernelSlot, or nullptr when this build can't have it
+#ifdef CHILI_X86
+#define CHILI_SSE2_KERNEL( f ) f
+#define CHILI_AVX2_KERNEL( f ) f
+#else
+#define CHILI_SSE2_KERNEL( f ) nullptr
+#define CHILI_AVX2_KERNEL( f ) nullptr
+#endif
+#ifdef CHILI_AVX512
+#define CHILI_AVX512_KERNEL( f ) f
+#else
+#define CHILI_AVX512_KERNEL( f ) nullptr
+#endif
@@ -21,6 +21,15 @@
 #pragma once
 #include <queue>
 #include <bitset>
+#ifdef _WIN32
+#include "ChiliWin.h"
+#else
+// virtual key codes used by the game (values from winuser.h) for headless builds
+#define VK_LEFT 0x25
+#define VK_UP 0x26
+#define VK_RIGHT 0x27
+#define VK_DOWN 0x28
+#endif
 
 class Keyboard
 {
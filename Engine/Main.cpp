@@ -21,16 +21,24 @@
 #include "MainWindow.h"
 #include "Game.h"
 #include "ChiliException.h"
-#include "GDIPlusManager.h"
+#include "KernelRegistry.h"
 
 int WINAPI wWinMain( HINSTANCE hInst,HINSTANCE,LPWSTR pArgs,INT )
 {
-	// this *should* be early enough to cover anything that uses gdip (Surfaces)
-	// could embed a gdipman instance in each surface to be extra sure, but meh
-	GDIPlusManager gdipMan;
 	try
 	{
 		MainWindow wnd( hInst,pArgs );		
+		// -simd=<tier> caps the pixel kernels for A/B benchmarking (CHILI_SIMD works too)
+		if( !KernelRegistry::ApplyArgs( wnd.GetArgs() ) )
+		{
+			wnd.ShowMessageBox( L"Bad argument",L"-simd must be scalar, sse2, avx2 or avx512",MB_ICONWARNING );
+		}
+		// -upload=direct draws straight into the mapped staging textures (Game reads it)
+		D3DFrameTarget::Upload upload = D3DFrameTarget::Upload::Copy;
+		if( !D3DFrameTarget::ParseArgs( wnd.GetArgs(),upload ) )
+		{
+			wnd.ShowMessageBox( L"Bad argument",L"-upload must be copy or direct",MB_ICONWARNING );
+		}
 		try
 		{
 			Game theGame( wnd );
@@ -21,15 +21,16 @@
 #pragma once
 #include "ChiliWin.h"
 #include "Graphics.h"
+#include "D3DFrameTarget.h"
 #include "Keyboard.h"
 #include "Mouse.h"
 #include "ChiliException.h"
 #include <string>
 
-// for granting special access to hWnd only for Graphics constructor
+// for granting special access to hWnd only for D3DFrameTarget constructor
 class HWNDKey
 {
-	friend Graphics::Graphics( HWNDKey& );
+	friend D3DFrameTarget::D3DFrameTarget( HWNDKey&,D3DFrameTarget::Upload );
 public:
 	HWNDKey( const HWNDKey& ) = delete;
 	HWNDKey& operator=( HWNDKey& ) = delete;
@@ -0,0 +1,89 @@
+#include "MappedFile.h"
+#include <stdexcept>
+#ifdef _WIN32
+// file mapping api is in the stuff ChiliWin.h normally strips out
+#define FULL_WINTARD
+#include "ChiliWin.h"
+#else
+#include "FilePath.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile( const std::wstring& filename )
+{
+	const std::string narrow( filename.begin(),filename.end() );
+#ifdef _WIN32
+	hFile = CreateFileW( filename.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,
+		OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr );
+	if( hFile == INVALID_HANDLE_VALUE )
+	{
+		hFile = nullptr;
+		throw std::runtime_error( "MappedFile::MappedFile failed to open file: " + narrow );
+	}
+	LARGE_INTEGER fileSize;
+	if( !GetFileSizeEx( hFile,&fileSize ) || fileSize.QuadPart == 0 )
+	{
+		CloseHandle( hFile );
+		throw std::runtime_error( "MappedFile::MappedFile empty or unreadable file: " + narrow );
+	}
+	size = size_t( fileSize.QuadPart );
+	hMapping = CreateFileMappingW( hFile,nullptr,PAGE_WRITECOPY,0,0,nullptr );
+	if( hMapping == nullptr )
+	{
+		CloseHandle( hFile );
+		throw std::runtime_error( "MappedFile::MappedFile failed to create mapping: " + narrow );
+	}
+	pData = static_cast<unsigned char*>( MapViewOfFile( hMapping,FILE_MAP_COPY,0,0,0 ) );
+	if( pData == nullptr )
+	{
+		CloseHandle( hMapping );
+		CloseHandle( hFile );
+		throw std::runtime_error( "MappedFile::MappedFile failed to map file: " + narrow );
+	}
+#else
+	const int fd = open( ToNarrowPath( filename ).c_str(),O_RDONLY );
+	if( fd < 0 )
+	{
+		throw std::runtime_error( "MappedFile::MappedFile failed to open file: " + narrow );
+	}
+	struct stat st;
+	if( fstat( fd,&st ) != 0 || st.st_size == 0 )
+	{
+		close( fd );
+		throw std::runtime_error( "MappedFile::MappedFile empty or unreadable file: " + narrow );
+	}
+	size = size_t( st.st_size );
+	void* const p = mmap( nullptr,size,PROT_READ | PROT_WRITE,MAP_PRIVATE,fd,0 );
+	// mapping stays valid after the descriptor is closed
+	close( fd );
+	if( p == MAP_FAILED )
+	{
+		throw std::runtime_error( "MappedFile::MappedFile failed to map file: " + narrow );
+	}
+	pData = static_cast<unsigned char*>( p );
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	UnmapViewOfFile( pData );
+	CloseHandle( hMapping );
+	CloseHandle( hFile );
+#else
+	munmap( pData,size );
+#endif
+}
+
+unsigned char* MappedFile::GetData() const
+{
+	return pData;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return size;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// maps a whole file into memory copy-on-write
+// (pages can be written through the mapping, but changes never reach the file)
+class MappedFile
+{
+public:
+	// throws std::runtime_error if the file can't be opened or mapped
+	MappedFile( const std::wstring& filename );
+	MappedFile( const MappedFile& ) = delete;
+	MappedFile& operator=( const MappedFile& ) = delete;
+	~MappedFile();
+	unsigned char* GetData() const;
+	size_t GetSize() const;
+private:
+	unsigned char* pData = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* hFile = nullptr;
+	void* hMapping = nullptr;
+#endif
+};
@@ -0,0 +1,146 @@
+#include "MemoryFrameTarget.h"
+#include "ChiliMemory.h"
+#include "BlitKernels.h"
+#include <new>
+
+MemoryFrameTarget::MemoryFrameTarget( Consumer consumer,Upload upload )
+	:
+	consumer( std::move( consumer ) ),
+	upload( upload )
+{}
+
+MemoryFrameTarget::~MemoryFrameTarget()
+{
+	for( auto& p : pBuffers )
+	{
+		if( p )
+		{
+			aligned_free( p );
+			p = nullptr;
+		}
+	}
+}
+
+void MemoryFrameTarget::PrepareBuffers( int width_in,int height_in )
+{
+	if( width_in == bufferWidth && height_in == bufferHeight )
+	{
+		return;
+	}
+	bufferWidth = width_in;
+	bufferHeight = height_in;
+	constexpr int pixelsPerRowAlignment = rowAlignment / int( sizeof( Color ) );
+	bufferPitch = (width_in + pixelsPerRowAlignment - 1) / pixelsPerRowAlignment * pixelsPerRowAlignment;
+	for( auto& p : pBuffers )
+	{
+		if( p )
+		{
+			aligned_free( p );
+		}
+		p = static_cast<Color*>( aligned_malloc( sizeof( Color ) * bufferPitch * height_in,rowAlignment ) );
+	}
+	if( pBuffers[0] == nullptr || pBuffers[1] == nullptr )
+	{
+		// forget the size, so the next frame tries again instead of using a missing buffer
+		bufferWidth = 0;
+		bufferHeight = 0;
+		throw std::bad_alloc();
+	}
+}
+
+Color* MemoryFrameTarget::AcquireFrame( int width_in,int height_in,int& pitch_out )
+{
+	if( upload != Upload::Direct )
+	{
+		return nullptr;
+	}
+	PrepareBuffers( width_in,height_in );
+	pitch_out = bufferPitch;
+	return pBuffers[iBuffer];
+}
+
+void MemoryFrameTarget::Present( const Color* pFrame,int width_in,int height_in,int pitch_in )
+{
+	// time since last present (first frame has nothing to measure against)
+	const float dt = ft.Mark();
+	if( frameCount > 0 )
+	{
+		totalFrameTime += dt;
+	}
+	frameCount++;
+
+	width = width_in;
+	height = height_in;
+	if( upload == Upload::None || (upload == Upload::Direct && pFrame == pBuffers[iBuffer]) )
+	{
+		// no copy here, we just take note of where the finished frame lives
+		pLastFrame = pFrame;
+		pitch = pitch_in;
+		presentTraffic = 0u;
+	}
+	else
+	{
+		// the frame isn't in an upload buffer, copy it over like the D3D target does
+		// (streaming stores, as into the write-combined texture)
+		PrepareBuffers( width,height );
+		Color* const pDst = pBuffers[iBuffer];
+		for( int y = 0; y < height; y++ )
+		{
+			BlitKernels::StreamCopy( pFrame + pitch_in * y,pDst + bufferPitch * y,width );
+		}
+		pLastFrame = pDst;
+		pitch = bufferPitch;
+		presentTraffic = 2u * sizeof( Color ) * size_t( width ) * size_t( height );
+	}
+	// next frame goes into the other buffer, the last one stays readable
+	iBuffer ^= 1;
+	if( consumer )
+	{
+		consumer( pLastFrame,width,height,pitch );
+	}
+}
+
+size_t MemoryFrameTarget::GetPresentTraffic() const
+{
+	return presentTraffic;
+}
+
+const Color* MemoryFrameTarget::GetLastFrame() const
+{
+	return pLastFrame;
+}
+
+int MemoryFrameTarget::GetWidth() const
+{
+	return width;
+}
+
+int MemoryFrameTarget::GetHeight() const
+{
+	return height;
+}
+
+int MemoryFrameTarget::GetPitch() const
+{
+	return pitch;
+}
+
+int MemoryFrameTarget::GetFrameCount() const
+{
+	return frameCount;
+}
+
+float MemoryFrameTarget::GetAverageFrameTime() const
+{
+	if( frameCount < 2 )
+	{
+		return 0.0f;
+	}
+	return totalFrameTime / float( frameCount - 1 );
+}
+
+void MemoryFrameTarget::ResetStats()
+{
+	frameCount = 0;
+	totalFrameTime = 0.0f;
+}
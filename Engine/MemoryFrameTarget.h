@@ -0,0 +1,66 @@
+#pragma once
+
+#include "FrameTarget.h"
+#include "FrameTimer.h"
+#include <functional>
+
+// headless frame target, nothing is shown anywhere
+// finished frames are handed over as raw pixels (valid until next BeginFrame)
+// and frame times are tracked so we can profile the frame pipeline without D3D
+class MemoryFrameTarget : public FrameTarget
+{
+public:
+	// consumer gets called with every finished frame (can be empty)
+	typedef std::function<void( const Color* pFrame,int width,int height,int pitch )> Consumer;
+	// what happens to the frame on present (mirrors D3DFrameTarget::Upload, used to measure
+	// the modes headless, see the upload section of ChiliBench)
+	enum class Upload
+	{
+		// nothing, we just take note of where the sysbuffer is
+		None,
+		// sysbuffer copied into an upload buffer of our own (what the D3D target does)
+		Copy,
+		// Graphics draws straight into one of two upload buffers of ours, nothing copied
+		Direct
+	};
+public:
+	MemoryFrameTarget( Consumer consumer = nullptr,Upload upload = Upload::None );
+	MemoryFrameTarget( const MemoryFrameTarget& ) = delete;
+	MemoryFrameTarget& operator=( const MemoryFrameTarget& ) = delete;
+	~MemoryFrameTarget();
+	Color* AcquireFrame( int width,int height,int& pitch ) override;
+	void Present( const Color* pFrame,int width,int height,int pitch ) override;
+	size_t GetPresentTraffic() const override;
+	// last frame that was presented (nullptr if none yet)
+	const Color* GetLastFrame() const;
+	int GetWidth() const;
+	int GetHeight() const;
+	// distance between the rows of the last frame in pixels
+	int GetPitch() const;
+	int GetFrameCount() const;
+	// mean time between presents in seconds (first present only starts the clock)
+	float GetAverageFrameTime() const;
+	// restart frame counting and timing
+	void ResetStats();
+private:
+	// (re)allocates the upload buffers when the frame size changes
+	void PrepareBuffers( int width,int height );
+private:
+	// upload buffer rows are padded like a mapped texture's would be
+	static constexpr int rowAlignment = 256;
+	Consumer consumer;
+	Upload upload;
+	Color* pBuffers[2] = { nullptr,nullptr };
+	int iBuffer = 0;
+	int bufferWidth = 0;
+	int bufferHeight = 0;
+	int bufferPitch = 0;
+	size_t presentTraffic = 0u;
+	const Color* pLastFrame = nullptr;
+	int width = 0;
+	int height = 0;
+	int pitch = 0;
+	int frameCount = 0;
+	float totalFrameTime = 0.0f;
+	FrameTimer ft;
+};
@@ -0,0 +1,39 @@
+#include "MirrorCache.h"
+
+// enough for every sprite in the game a few times over
+std::atomic<size_t> MirrorBudget::budget = { 16u * 1024u * 1024u };
+std::atomic<size_t> MirrorBudget::used = { 0u };
+
+void MirrorBudget::SetBudget( size_t bytes )
+{
+	budget = bytes;
+}
+
+size_t MirrorBudget::GetBudget()
+{
+	return budget;
+}
+
+size_t MirrorBudget::GetUsed()
+{
+	return used;
+}
+
+bool MirrorBudget::Reserve( size_t bytes )
+{
+	size_t cur = used.load();
+	do
+	{
+		if( cur + bytes > budget.load() )
+		{
+			return false;
+		}
+	}
+	while( !used.compare_exchange_weak( cur,cur + bytes ) );
+	return true;
+}
+
+void MirrorBudget::Release( size_t bytes )
+{
+	used -= bytes;
+}
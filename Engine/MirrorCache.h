@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+
+// memory budget shared by all mirrored sprite copies
+// (budget of 0 turns mirror caching off, mirrored draws then read the source backwards)
+class MirrorBudget
+{
+public:
+	static void SetBudget( size_t bytes );
+	static size_t GetBudget();
+	// bytes currently held by mirrored copies
+	static size_t GetUsed();
+	// claim bytes from the budget, false if that would go over
+	static bool Reserve( size_t bytes );
+	static void Release( size_t bytes );
+private:
+	static std::atomic<size_t> budget;
+	static std::atomic<size_t> used;
+};
+
+// horizontally flipped copy of a T, built the first time it is asked for
+// safe to call Get from several threads at once (the render bands do)
+template<typename T>
+class MirrorCache
+{
+public:
+	MirrorCache() = default;
+	// copies start with an empty cache (the owner copy can be changed afterwards)
+	MirrorCache( const MirrorCache& )
+	{}
+	MirrorCache& operator=( const MirrorCache& )
+	{
+		Reset();
+		return *this;
+	}
+	~MirrorCache()
+	{
+		Reset();
+	}
+	// returns the mirrored copy, building it with build() if needed
+	// nullptr if it does not fit in the budget
+	template<typename F>
+	const T* Get( size_t bytes,F build ) const
+	{
+		// fast path, already built
+		if( const T* p = pReady.load( std::memory_order_acquire ) )
+		{
+			return p;
+		}
+		std::lock_guard<std::mutex> lock( mtx );
+		if( !pMirror )
+		{
+			if( !MirrorBudget::Reserve( bytes ) )
+			{
+				return nullptr;
+			}
+			pMirror = std::make_unique<T>( build() );
+			size = bytes;
+			pReady.store( pMirror.get(),std::memory_order_release );
+		}
+		return pMirror.get();
+	}
+	// throw away the mirrored copy (must be called when the owner changes)
+	// not safe to call while other threads are drawing the owner
+	void Reset()
+	{
+		if( pMirror )
+		{
+			pReady.store( nullptr,std::memory_order_relaxed );
+			pMirror.reset();
+			MirrorBudget::Release( size );
+			size = 0;
+		}
+	}
+private:
+	mutable std::mutex mtx;
+	mutable std::unique_ptr<T> pMirror;
+	mutable std::atomic<const T*> pReady = { nullptr };
+	mutable size_t size = 0;
+};
@@ -89,7 +89,7 @@ void Mouse::OnMouseMove( int newx,int newy )
 	TrimBuffer();
 }
 
-void Mouse::OnLeftPressed( int x,int y )
+void Mouse::OnLeftPressed( int /*x*/,int /*y*/ )
 {
 	leftIsPressed = true;
 
@@ -97,7 +97,7 @@ void Mouse::OnLeftPressed( int x,int y )
 	TrimBuffer();
 }
 
-void Mouse::OnLeftReleased( int x,int y )
+void Mouse::OnLeftReleased( int /*x*/,int /*y*/ )
 {
 	leftIsPressed = false;
 
@@ -105,7 +105,7 @@ void Mouse::OnLeftReleased( int x,int y )
 	TrimBuffer();
 }
 
-void Mouse::OnRightPressed( int x,int y )
+void Mouse::OnRightPressed( int /*x*/,int /*y*/ )
 {
 	rightIsPressed = true;
 
@@ -113,7 +113,7 @@ void Mouse::OnRightPressed( int x,int y )
 	TrimBuffer();
 }
 
-void Mouse::OnRightReleased( int x,int y )
+void Mouse::OnRightReleased( int /*x*/,int /*y*/ )
 {
 	rightIsPressed = false;
 
@@ -121,13 +121,13 @@ void Mouse::OnRightReleased( int x,int y )
 	TrimBuffer();
 }
 
-void Mouse::OnWheelUp( int x,int y )
+void Mouse::OnWheelUp( int /*x*/,int /*y*/ )
 {
 	buffer.push( Mouse::Event( Mouse::Event::Type::WheelUp,*this ) );
 	TrimBuffer();
 }
 
-void Mouse::OnWheelDown( int x,int y )
+void Mouse::OnWheelDown( int /*x*/,int /*y*/ )
 {
 	buffer.push( Mouse::Event( Mouse::Event::Type::WheelDown,*this ) );
 	TrimBuffer();
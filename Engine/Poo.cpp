@@ -1,169 +1,231 @@
 #include "Poo.h"
 #include "World.h"
 
-Poo::Poo( const Vec2& pos )
+// (push_back takes it by reference, so it needs a definition)
+constexpr int PooStore::startHp;
+
+PooStore::PooStore( int capacity )
 	:
-	pos( pos )
-{}
+	capacity( capacity )
+{
+	positions.reserve( capacity );
+	velocities.reserve( capacity );
+	effectTimes.reserve( capacity );
+	effectStates.reserve( capacity );
+	hps.reserve( capacity );
+	grid.Reserve( capacity );
+	// load the shared stuff now instead of in the middle of the first hit
+	GetSprite();
+	GetHitSound();
+	GetDeathSound();
+}
+
+bool PooStore::Spawn( const Vec2& pos )
+{
+	if( GetCount() == capacity )
+	{
+		return false;
+	}
+	positions.push_back( pos );
+	velocities.push_back( { 0.0f,0.0f } );
+	effectTimes.push_back( 0.0f );
+	effectStates.push_back( EffectState::Normal );
+	hps.push_back( startHp );
+	return true;
+}
+
+int PooStore::GetCount() const
+{
+	return int( positions.size() );
+}
+
+const Vec2& PooStore::GetPos( int i ) const
+{
+	return positions[i];
+}
+
+RectF PooStore::GetHitbox( int i ) const
+{
+	return RectF::FromCenter( positions[i],hitbox_halfwidth,hitbox_halfheight );
+}
+
+bool PooStore::IsDead( int i ) const
+{
+	return hps[i] <= 0;
+}
 
-void Poo::Draw( Graphics& gfx ) const
+void PooStore::ApplyDamage( int i,float damage )
 {
-	// calculate drawing base
-	const auto draw_pos = pos + draw_offset;
-	// switch on effectState to determine drawing method
-	switch( effectState )
+	hps[i] -= int( damage );
+	effectStates[i] = EffectState::Hit;
+	effectTimes[i] = 0.0f;
+	// play sound effects
+	GetHitSound()->Play( 0.9f,0.3f );
+	if( IsDead( i ) )
 	{
-	case EffectState::Hit:
-		// flash white for hit
-		gfx.DrawSprite( int( draw_pos.x ),int( draw_pos.y ),*pPooSurface,
-			SpriteEffect::Substitution{ Colors::White,Colors::White }
-		);
-		break;
-	case EffectState::Dying:
-		// draw dissolve effect during dying (tint red)
-		gfx.DrawSprite( int( draw_pos.x ),int( draw_pos.y ),*pPooSurface,
-			SpriteEffect::DissolveHalfTint{ Colors::White,Colors::Red,
-			1.0f - effectTime / dissolveDuration }
-		);
-		break;
-	case EffectState::Normal:
-		gfx.DrawSprite( int( draw_pos.x ),int( draw_pos.y ),*pPooSurface,
-			SpriteEffect::Chroma{ Colors::White }
-		);
-		break;
+		GetDeathSound()->Play( 1.0f,0.8f );
 	}
 }
 
-void Poo::ProcessLogic( const World& world )
+void PooStore::ProcessLogic( const World& world )
 {
-	// flag for avoidance state
-	bool avoiding = false;
-	// if close to any enemy, avoid it
-	for( auto& other : world.GetPoosConst() )
+	const int count = GetCount();
+	// bin the poos once so each one only looks at its neighbors when avoiding
+	grid.Build( positions.data(),count,avoidanceRadius );
+	const Vec2 target = world.GetChiliConst().GetPos();
+	for( int self = 0; self < count; self++ )
 	{
-		// don't consider self
-		if( this == &other )
+		const Vec2 pos = positions[self];
+		// if close to any enemy, avoid it
+		// (the first one in poo order, only the neighboring grid cells can have it)
+		const int avoidee = grid.FindFirstWithin( positions.data(),self,avoidanceRadius );
+		Vec2 dir = { 0.0f,0.0f };
+		if( avoidee >= 0 )
 		{
-			continue;
-		}
-		// check if poo is within theshold (hardcoded here as thresh^2)
-		const auto delta = GetPos() - other.GetPos();
-		const auto lensq = delta.GetLengthSq();
-		if( lensq < 400.0f )
-		{
-			// avoiding state set
-			avoiding = true;
+			const float avoideeLensq = (pos - positions[avoidee]).GetLengthSq();
 			// case for poos at same location
-			if( lensq == 0.0f )
+			if( avoideeLensq == 0.0f )
 			{
-				 SetDirection( { -1.0f,1.0f } );
+				dir = { -1.0f,1.0f };
 			}
 			else
 			{
 				// normalize delta to get dir (reusing precalculated lensq)
 				// if you would have just called Normalize() like a good boy...
-				SetDirection( delta / std::sqrt( lensq ) );
+				dir = (pos - positions[avoidee]) / std::sqrt( avoideeLensq );
 			}
-			// no need to check other poos
-			break;
-		}
-	}
-	// check if in avoidance state, if so do not pursue
-	if( !avoiding )
-	{
-		const auto delta = world.GetChiliConst().GetPos() - GetPos();
-		// we only wanna move if not already really close to target pos
-		// (prevents vibrating around target point; 3.0 just a number pulled out of butt)
-		if( delta.GetLengthSq() > 3.0f )
-		{
-			SetDirection( delta.GetNormalized() );
 		}
 		else
 		{
-			SetDirection( { 0.0f,0.0f } );
+			// not avoiding, so pursue
+			const auto delta = target - pos;
+			// we only wanna move if not already really close to target pos
+			// (prevents vibrating around target point; 3.0 just a number pulled out of butt)
+			if( delta.GetLengthSq() > 3.0f )
+			{
+				dir = delta.GetNormalized();
+			}
 		}
+		// this does not perform normalization
+		velocities[self] = dir * speed;
 	}
 }
 
-void Poo::Update( const World& world,float dt )
+void PooStore::Update( const World& world,float dt )
 {
-	// dead poos tell no tales (or even move for that matter)
-	if( !IsDead() )
+	const Boundary& bounds = world.GetBoundsConst();
+	for( int i = 0; i < GetCount(); i++ )
 	{
-		pos += vel * dt;
-	}
+		// dead poos tell no tales (or even move for that matter)
+		if( !IsDead( i ) )
+		{
+			positions[i] += velocities[i] * dt;
+		}
 
-	// always update effect time (who cares brah?)
-	effectTime += dt;
-	// effect state machine logic
-	switch( effectState )
-	{
-	case EffectState::Hit:
-		if( effectTime >= hitFlashDuration )
+		// always update effect time (who cares brah?)
+		effectTimes[i] += dt;
+		// effect state machine logic
+		switch( effectStates[i] )
 		{
-			// if we are dead, transition to dying dissolve state
-			if( IsDead() )
-			{
-				effectState = EffectState::Dying;
-				effectTime = 0.0f;
-			}
-			else
+		case EffectState::Hit:
+			if( effectTimes[i] >= hitFlashDuration )
 			{
-				effectState = EffectState::Normal;
+				// if we are dead, transition to dying dissolve state
+				if( IsDead( i ) )
+				{
+					effectStates[i] = EffectState::Dying;
+					effectTimes[i] = 0.0f;
+				}
+				else
+				{
+					effectStates[i] = EffectState::Normal;
+				}
 			}
+			break;
+		default:
+			// normal doesn't change on its own, finished dying poos go in RemoveFinished
+			break;
 		}
-		break;
-	case EffectState::Dying:
-		if( effectTime >= dissolveDuration )
-		{
-			// dissolve finished, get this traysh outta ere!
-			isReadyForRemoval = true;
-		}
-		break;
+		// adjust to boundary (crude collision)
+		positions[i] += bounds.GetDisplacement( GetHitbox( i ) );
 	}
-	// adjust to boundary (crude collision)
-	world.GetBoundsConst().Adjust( *this );
 }
 
-void Poo::ApplyDamage( float damage )
+void PooStore::Draw( RenderQueue& rq ) const
 {
-	hp -= int( damage );
-	effectState = EffectState::Hit;
-	effectTime = 0.0f;
-	// play sound effects
-	pHitSound->Play( 0.9f,0.3f );
-	if( IsDead() )
+	for( int i = 0; i < GetCount(); i++ )
 	{
-		pDeathSound->Play( 1.0f,0.8f );
+		// depth sort on base position
+		rq.SetSortKey( RenderQueue::Layer::Entities,int( positions[i].y ) );
+		// calculate drawing base
+		const int x = int( positions[i].x + draw_offset_x );
+		const int y = int( positions[i].y + draw_offset_y );
+		// switch on effectState to determine drawing method
+		switch( effectStates[i] )
+		{
+		case EffectState::Hit:
+			// flash white for hit
+			rq.DrawSprite( x,y,GetSprite(),
+				SpriteEffect::Fill{ Colors::White }
+			);
+			break;
+		case EffectState::Dying:
+			// draw dissolve effect during dying (tint red)
+			rq.DrawSprite( x,y,GetSprite(),
+				SpriteEffect::DissolveHalfTint{ Colors::White,Colors::Red,
+				1.0f - effectTimes[i] / dissolveDuration }
+			);
+			break;
+		case EffectState::Normal:
+			// compiled sprite only has opaque pixels, so a straight copy does the chroma keying
+			rq.DrawSprite( x,y,GetSprite(),
+				SpriteEffect::Copy{}
+			);
+			break;
+		}
 	}
 }
 
-const Vec2& Poo::GetPos() const
-{
-	return pos;
-}
-
-RectF Poo::GetHitbox() const
-{
-	return RectF::FromCenter( pos,hitbox_halfwidth,hitbox_halfheight );
-}
-
-bool Poo::IsDead() const
+void PooStore::RemoveFinished()
 {
-	return hp <= 0;
+	// one compaction pass over every array
+	int nKept = 0;
+	for( int i = 0; i < GetCount(); i++ )
+	{
+		// dissolve finished, get this traysh outta ere!
+		if( effectStates[i] == EffectState::Dying && effectTimes[i] >= dissolveDuration )
+		{
+			continue;
+		}
+		positions[nKept] = positions[i];
+		velocities[nKept] = velocities[i];
+		effectTimes[nKept] = effectTimes[i];
+		effectStates[nKept] = effectStates[i];
+		hps[nKept] = hps[i];
+		nKept++;
+	}
+	positions.resize( nKept );
+	velocities.resize( nKept );
+	effectTimes.resize( nKept );
+	effectStates.resize( nKept );
+	hps.resize( nKept );
 }
 
-bool Poo::IsReadyForRemoval() const
+const CompiledSprite& PooStore::GetSprite()
 {
-	return isReadyForRemoval;
+	// compiled on first use, white is the chroma for the poo sprite
+	static const CompiledSprite sprite( *Codex<Surface>::Retrieve( L"Images\\poo.bmp" ),Colors::White );
+	return sprite;
 }
 
-void Poo::DisplaceBy( const Vec2& d )
+const Sound* PooStore::GetHitSound()
 {
-	pos += d;
+	static const Sound* const pSound = Codex<Sound>::Retrieve( L"Sounds\\fhit.wav" );
+	return pSound;
 }
 
-void Poo::SetDirection( const Vec2& dir )
+const Sound* PooStore::GetDeathSound()
 {
-	vel = dir * speed;
+	static const Sound* const pSound = Codex<Sound>::Retrieve( L"Sounds\\monster_death.wav" );
+	return pSound;
 }
@@ -1,57 +1,82 @@
 #pragma once
 
 #include "Vec2.h"
+#include "Rect.h"
 #include "SpriteEffect.h"
 #include "Codex.h"
 #include "Sound.h"
 #include "Surface.h"
+#include "CompiledSprite.h"
+#include "RenderQueue.h"
+#include "SpatialGrid.h"
+#include <vector>
 
-class Poo
+// all the poos in the world, one slot in each array per poo (structure of arrays)
+// everything poos have in common is shared below instead of stored per poo,
+// and each per frame pass walks only the arrays it needs
+// storage for capacity poos is set aside up front, spawning and removing poos
+// never touches the heap after that
+class PooStore
 {
 private:
-	enum class EffectState
+	enum class EffectState : unsigned char
 	{
 		Normal,
 		Hit,
 		Dying
 	};
 public:
-	Poo( const Vec2& pos );
-	void Draw( Graphics& gfx ) const;
-	// here the poo does it's 'thinking' and decides its actions
+	// poos closer than this to another poo move away from it instead of chasing chili
+	static constexpr float avoidanceRadius = 20.0f;
+	// hitbox dimensions
+	static constexpr float hitbox_halfwidth = 11.0f;
+	static constexpr float hitbox_halfheight = 4.0f;
+public:
+	PooStore( int capacity );
+	// returns false (and spawns nothing) if the store is full
+	bool Spawn( const Vec2& pos );
+	int GetCount() const;
+	const Vec2& GetPos( int i ) const;
+	RectF GetHitbox( int i ) const;
+	bool IsDead( int i ) const;
+	void ApplyDamage( int i,float damage );
+	// here the poos do their 'thinking' and decide their actions
 	void ProcessLogic( const class World& world );
-	// here the poo updates physical state based on the dt and the world
+	// here the poos update physical state based on the dt and the world
 	void Update( const World& world,float dt );
-	void ApplyDamage( float damage );
-	const Vec2& GetPos() const;
-	RectF GetHitbox() const;
-	bool IsDead() const;
-	bool IsReadyForRemoval() const;
-	void DisplaceBy( const Vec2& d );
-private:
-	// this does not perform normalization
-	void SetDirection( const Vec2& dir );
+	void Draw( RenderQueue& rq ) const;
+	// drops the poos that have finished dissolving (order of the rest is kept)
+	void RemoveFinished();
+	// bytes one poo takes up across the arrays (capacity of these is reserved up front)
+	static constexpr size_t GetSlotBytes()
+	{
+		return sizeof( decltype( positions )::value_type ) + sizeof( decltype( velocities )::value_type ) +
+			sizeof( decltype( effectTimes )::value_type ) + sizeof( decltype( effectStates )::value_type ) +
+			sizeof( decltype( hps )::value_type );
+	}
 private:
-	const Surface* pPooSurface = Codex<Surface>::Retrieve( L"Images\\poo.bmp" );
+	// poo sprite compiled to opaque runs
+	static const CompiledSprite& GetSprite();
 	// sound when fireball hits poo
-	const Sound* pHitSound = Codex<Sound>::Retrieve( L"Sounds\\fhit.wav" );
+	static const Sound* GetHitSound();
 	// sound when poo dies
-	const Sound* pDeathSound = Codex<Sound>::Retrieve( L"Sounds\\monster_death.wav" );
-	Vec2 pos;
-	// hitbox dimensions
-	float hitbox_halfwidth = 11.0f;
-	float hitbox_halfheight = 4.0f;
+	static const Sound* GetDeathSound();
+private:
 	// this value give the offset from the actual base of the
 	// character to its drawing base
-	Vec2 draw_offset = { -11.0f,-19.0f };
-	Vec2 vel = { 0.0f,0.0f };
-	// used to keep track of graphical facing (for sprite mirroring)
-	float speed = 90.0f;
+	static constexpr float draw_offset_x = -11.0f;
+	static constexpr float draw_offset_y = -19.0f;
+	static constexpr float speed = 90.0f;
 	static constexpr float dissolveDuration = 0.6f;
 	static constexpr float hitFlashDuration = 0.045f;
-	float effectTime = 0.0f;
-	EffectState effectState = EffectState::Normal;
-	bool isReadyForRemoval = false;
-	// hitpoints
-	int hp = 100;
-};
\ No newline at end of file
+	// hitpoints poos start with
+	static constexpr int startHp = 100;
+	int capacity;
+	std::vector<Vec2> positions;
+	std::vector<Vec2> velocities;
+	std::vector<float> effectTimes;
+	std::vector<EffectState> effectStates;
+	std::vector<int> hps;
+	// positions binned for the avoidance checks (rebuilt in ProcessLogic)
+	SpatialGrid grid;
+};
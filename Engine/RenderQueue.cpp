@@ -0,0 +1,145 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <iterator>
+
+RenderQueue::RenderQueue( int nBands_in )
+	:
+	nBands( nBands_in )
+{
+	if( nBands <= 0 )
+	{
+		// hardware_concurrency is allowed to return 0 if it doesn't know
+		nBands = std::max( int( std::thread::hardware_concurrency() ),1 );
+	}
+	// no point having bands thinner than a pixel row
+	nBands = std::min( nBands,int( Graphics::ScreenHeight ) );
+	for( int band = 1; band < nBands; band++ )
+	{
+		workers.emplace_back( &RenderQueue::WorkerLoop,this,band );
+	}
+}
+
+RenderQueue::~RenderQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock( mtx );
+		quitting = true;
+	}
+	cvStart.notify_all();
+	for( auto& w : workers )
+	{
+		w.join();
+	}
+}
+
+void RenderQueue::SetSortKey( Layer layer,int sortY )
+{
+	curLayer = layer;
+	curSortY = sortY;
+	curSubOrder = 0;
+}
+
+void RenderQueue::Render( Graphics& gfx )
+{
+	// no two commands compare equal (submission order breaks the last ties)
+	std::sort( commands.begin(),commands.end() );
+	std::fill( std::begin( lastFrameCommandCounts ),std::end( lastFrameCommandCounts ),0 );
+	for( const auto& cmd : commands )
+	{
+		lastFrameCommandCounts[int( cmd.layer )]++;
+	}
+	if( !workers.empty() )
+	{
+		// wake the workers for their bands
+		{
+			std::lock_guard<std::mutex> lock( mtx );
+			pGfx = &gfx;
+			nPendingWorkers = int( workers.size() );
+			frameId++;
+		}
+		cvStart.notify_all();
+	}
+	// this thread takes the top band
+	RenderBand( 0,gfx );
+	if( !workers.empty() )
+	{
+		std::unique_lock<std::mutex> lock( mtx );
+		cvDone.wait( lock,[this](){ return nPendingWorkers == 0; } );
+	}
+	commands.clear();
+	SetSortKey( Layer::Entities,0 );
+}
+
+void RenderQueue::Reserve( int nCommands )
+{
+	commands.reserve( nCommands );
+}
+
+int RenderQueue::GetBandCount() const
+{
+	return nBands;
+}
+
+int RenderQueue::GetCommandCount() const
+{
+	return int( commands.size() );
+}
+
+int RenderQueue::GetLastFrameCommandCount() const
+{
+	int count = 0;
+	for( int n : lastFrameCommandCounts )
+	{
+		count += n;
+	}
+	return count;
+}
+
+int RenderQueue::GetLastFrameCommandCount( Layer layer ) const
+{
+	return lastFrameCommandCounts[int( layer )];
+}
+
+void RenderQueue::RenderBand( int band,Graphics& gfx ) const
+{
+	const RectI bandRect = GetBandRect( band );
+	for( const auto& cmd : commands )
+	{
+		// commands that miss the band entirely are rejected by the clipping in DrawSprite
+		cmd.exec( cmd,gfx,cmd.clip.GetClippedTo( bandRect ) );
+	}
+}
+
+RectI RenderQueue::GetBandRect( int band ) const
+{
+	return RectI(
+		0,Graphics::ScreenWidth,
+		Graphics::ScreenHeight * band / nBands,
+		Graphics::ScreenHeight * (band + 1) / nBands
+	);
+}
+
+void RenderQueue::WorkerLoop( int band )
+{
+	unsigned int lastFrame = 0u;
+	while( true )
+	{
+		Graphics* pTarget;
+		{
+			std::unique_lock<std::mutex> lock( mtx );
+			cvStart.wait( lock,[this,lastFrame](){ return quitting || frameId != lastFrame; } );
+			if( quitting )
+			{
+				return;
+			}
+			lastFrame = frameId;
+			pTarget = pGfx;
+		}
+		RenderBand( band,*pTarget );
+		{
+			std::lock_guard<std::mutex> lock( mtx );
+			nPendingWorkers--;
+		}
+		cvDone.notify_one();
+	}
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "Graphics.h"
+#include "Surface.h"
+#include "CompiledSprite.h"
+#include "Rect.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+#include <new>
+#include <functional>
+
+// records sprite draws during the frame instead of rasterizing them immediately
+// Render() then plays the recorded commands back into Graphics split into horizontal
+// screen bands, one per thread, with each band passed as the DrawSprite clip rect
+// (bands never share pixels, so output is identical to drawing the commands in order)
+//
+// commands are keyed with the current sort key (see SetSortKey) and sorted before
+// rasterizing: by layer, then sort y (entities further down the screen go on top),
+// then order of submission within the key, then source sprite (so equal-depth draws
+// of the same image end up back to back)
+class RenderQueue
+{
+public:
+	enum class Layer
+	{
+		Underlay,
+		Entities,
+		Overlay,
+		Count
+	};
+private:
+	class Command
+	{
+	public:
+		// calls Graphics::DrawSprite with the recorded parameters and effect type
+		typedef void( *Executor )( const Command& cmd,Graphics& gfx,const RectI& clip );
+		// effects are stored inline (no allocation per command)
+		static constexpr size_t maxEffectSize = 32;
+	public:
+		Command( Layer layer,int sortY,int subOrder,int seq,Executor exec,const void* pSprite,
+			const RectI& srcRect,const RectI& clip,int x,int y,bool reversed )
+			:
+			layer( layer ),
+			sortY( sortY ),
+			subOrder( subOrder ),
+			seq( seq ),
+			exec( exec ),
+			pSprite( pSprite ),
+			srcRect( srcRect ),
+			clip( clip ),
+			x( x ),
+			y( y ),
+			reversed( reversed )
+		{}
+		bool operator<( const Command& rhs ) const
+		{
+			if( layer != rhs.layer )
+			{
+				return layer < rhs.layer;
+			}
+			if( sortY != rhs.sortY )
+			{
+				return sortY < rhs.sortY;
+			}
+			if( subOrder != rhs.subOrder )
+			{
+				return subOrder < rhs.subOrder;
+			}
+			if( pSprite != rhs.pSprite )
+			{
+				return std::less<const void*>()( pSprite,rhs.pSprite );
+			}
+			return seq < rhs.seq;
+		}
+	public:
+		// sort key
+		Layer layer;
+		int sortY;
+		int subOrder;
+		// position in the frame's submissions, so fully tied commands keep their order
+		// without a stable sort (std::stable_sort allocates a buffer every call)
+		int seq;
+		// draw parameters
+		Executor exec;
+		const void* pSprite;
+		RectI srcRect;
+		RectI clip;
+		int x;
+		int y;
+		bool reversed;
+		typename std::aligned_storage<maxEffectSize,alignof( double )>::type effect;
+	};
+public:
+	// nBands <= 0 uses one band per hardware thread
+	RenderQueue( int nBands = 0 );
+	RenderQueue( const RenderQueue& ) = delete;
+	RenderQueue& operator=( const RenderQueue& ) = delete;
+	~RenderQueue();
+	// key for the draws submitted after this call (until the next call)
+	// draws under one key keep their submission order (e.g. legs then head)
+	void SetSortKey( Layer layer,int sortY );
+	template<typename E>
+	void DrawSprite( int x,int y,const Surface& s,E effect,bool reversed = false )
+	{
+		DrawSprite( x,y,s.GetRect(),s,effect,reversed );
+	}
+	template<typename E>
+	void DrawSprite( int x,int y,const RectI& srcRect,const Surface& s,E effect,bool reversed = false )
+	{
+		DrawSprite( x,y,srcRect,Graphics::GetScreenRect(),s,effect,reversed );
+	}
+	template<typename E>
+	void DrawSprite( int x,int y,const RectI& srcRect,const RectI& clip,const Surface& s,E effect,bool reversed = false )
+	{
+		Record( &ExecuteSurface<E>,&s,srcRect,clip,x,y,effect,reversed );
+	}
+	template<typename E>
+	void DrawSprite( int x,int y,const CompiledSprite& s,E effect,bool reversed = false )
+	{
+		Record( &ExecuteCompiled<E>,&s,s.GetRect(),Graphics::GetScreenRect(),x,y,effect,reversed );
+	}
+	// makes room for frames of up to nCommands draws, so recording them never allocates
+	void Reserve( int nCommands );
+	// sort and rasterize all recorded commands into gfx (in parallel bands) and clear the queue
+	void Render( Graphics& gfx );
+	int GetBandCount() const;
+	// commands recorded so far this frame
+	int GetCommandCount() const;
+	// commands rasterized by the last Render (total and per layer)
+	int GetLastFrameCommandCount() const;
+	int GetLastFrameCommandCount( Layer layer ) const;
+private:
+	template<typename E>
+	void Record( Command::Executor exec,const void* pSprite,const RectI& srcRect,const RectI& clip,
+		int x,int y,const E& effect,bool reversed )
+	{
+		// effects are copied around as raw bytes and never destroyed
+		static_assert( std::is_trivially_copyable<E>::value,"Effect must be trivially copyable" );
+		static_assert( std::is_trivially_destructible<E>::value,"Effect must be trivially destructible" );
+		static_assert( sizeof( E ) <= Command::maxEffectSize,"Effect too big for render command" );
+		static_assert( alignof( E ) <= alignof( double ),"Effect alignment too strict for render command" );
+		commands.emplace_back( curLayer,curSortY,curSubOrder++,int( commands.size() ),exec,pSprite,srcRect,clip,x,y,reversed );
+		new( &commands.back().effect ) E( effect );
+	}
+	template<typename E>
+	static void ExecuteSurface( const Command& cmd,Graphics& gfx,const RectI& clip )
+	{
+		gfx.DrawSprite( cmd.x,cmd.y,cmd.srcRect,clip,*static_cast<const Surface*>( cmd.pSprite ),
+			*reinterpret_cast<const E*>( &cmd.effect ),cmd.reversed );
+	}
+	template<typename E>
+	static void ExecuteCompiled( const Command& cmd,Graphics& gfx,const RectI& clip )
+	{
+		gfx.DrawSprite( cmd.x,cmd.y,clip,*static_cast<const CompiledSprite*>( cmd.pSprite ),
+			*reinterpret_cast<const E*>( &cmd.effect ),cmd.reversed );
+	}
+	// plays back every command clipped to band (on the calling thread)
+	void RenderBand( int band,Graphics& gfx ) const;
+	RectI GetBandRect( int band ) const;
+	void WorkerLoop( int band );
+private:
+	std::vector<Command> commands;
+	// key applied to newly recorded commands
+	Layer curLayer = Layer::Entities;
+	int curSortY = 0;
+	int curSubOrder = 0;
+	// stats of the last rendered frame
+	int lastFrameCommandCounts[int( Layer::Count )] = {};
+	int nBands;
+	// band 0 is done by the thread calling Render, the rest by these workers
+	std::vector<std::thread> workers;
+	std::mutex mtx;
+	std::condition_variable cvStart;
+	std::condition_variable cvDone;
+	// incremented to kick the workers off on a new frame
+	unsigned int frameId = 0u;
+	int nPendingWorkers = 0;
+	bool quitting = false;
+	Graphics* pGfx = nullptr;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// stand-ins for Sound and SoundEffect in builds without xaudio (see CMakeLists.txt)
+// same interface as the real classes for everything the game uses, but nothing
+// is loaded and nothing plays, so the world can be updated and drawn headless
+class Sound
+{
+public:
+	enum class LoopType
+	{
+		NotLooping,
+		AutoEmbeddedCuePoints,
+		AutoFullSound,
+		ManualFloat,
+		ManualSample,
+		Invalid
+	};
+public:
+	Sound() = default;
+	Sound( const std::wstring& /*fileName*/,bool /*loopingWithAutoCueDetect*/ )
+	{}
+	Sound( const std::wstring& /*fileName*/,LoopType /*loopType*/ = LoopType::NotLooping )
+	{}
+	void Play( float /*freqMod*/ = 1.0f,float /*vol*/ = 1.0f ) const
+	{}
+	void StopOne() const
+	{}
+	void StopAll() const
+	{}
+};
+
+class SoundEffect
+{
+public:
+	SoundEffect( const std::wstring& /*filename*/ )
+	{}
+	SoundEffect( std::vector<std::wstring> /*wavFiles*/,bool /*soft_fail*/ = false,float /*freqStdDevFactor*/ = 0.06f )
+	{}
+	template<class T>
+	void Play( T& /*rng*/,float /*vol*/ = 1.0f ) const
+	{}
+	void Play( float /*vol*/ = 1.0f ) const
+	{}
+};
@@ -200,6 +200,9 @@ SoundSystem::SoundSystem()
 	}
 
 	// create channel objects
+	// (both lists get room for all of them, so moving channels between them never allocates)
+	idleChannelPtrs.reserve( nChannels );
+	activeChannelPtrs.reserve( nChannels );
 	for( int i = 0; i < nChannels; i++ )
 	{
 		idleChannelPtrs.push_back( std::make_unique<Channel>( *this ) );
@@ -932,6 +935,13 @@ Sound::Sound( const std::wstring& fileName,LoopType loopType,
 	}
 }
 
+std::vector<SoundSystem::Channel*> Sound::MakeChannelList()
+{
+	std::vector<SoundSystem::Channel*> list;
+	list.reserve( SoundSystem::GetChannelCount() );
+	return list;
+}
+
 Sound::Sound( Sound&& donor )
 {
 	std::lock_guard<std::mutex> lock( donor.mutex );
@@ -941,7 +951,8 @@ Sound::Sound( Sound&& donor )
 	loopStart = donor.loopStart;
 	loopEnd = donor.loopEnd;
 	pData = std::move( donor.pData );
-	activeChannelPtrs = std::move( donor.activeChannelPtrs );
+	// swap so the donor keeps a preallocated (empty) list too
+	activeChannelPtrs.swap( donor.activeChannelPtrs );
 	for( auto& pChan : activeChannelPtrs )
 	{
 		pChan->RetargetSound( &donor,this );
@@ -972,7 +983,8 @@ Sound& Sound::operator=( Sound && donor )
 	loopStart = donor.loopStart;
 	loopEnd = donor.loopEnd;
 	pData = std::move( donor.pData );
-	activeChannelPtrs = std::move( donor.activeChannelPtrs );	
+	// ours is empty by now, swap so the donor keeps a preallocated list
+	activeChannelPtrs.swap( donor.activeChannelPtrs );
 	for( auto& pChan : activeChannelPtrs )
 	{
 		pChan->RetargetSound( &donor,this );
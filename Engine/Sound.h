@@ -19,6 +19,10 @@
  *	along with this source code.  If not, see <http://www.gnu.org/licenses/>.			  *
  ******************************************************************************************/
 #pragma once
+#ifndef _WIN32
+// headless builds get silent stand-ins (no xaudio / media foundation)
+#include "SilentSound.h"
+#else
 #include "ChiliWin.h"
 #include <memory>
 #include <vector>
@@ -114,6 +118,11 @@ public:
 	static SoundSystem& Get();
 	static void SetMasterVolume( float vol = 1.0f );
 	static const WAVEFORMATEX& GetFormat();
+	// most sounds that can play at once
+	static constexpr size_t GetChannelCount()
+	{
+		return nChannels;
+	}
 	void PlaySoundBuffer( const class Sound& s,float freqMod,float vol );
 private:
 	SoundSystem();
@@ -172,6 +181,8 @@ private:
 	Sound( const std::wstring& fileName,LoopType loopType,
 		unsigned int loopStartSample,unsigned int loopEndSample,
 		float loopStartSeconds,float loopEndSeconds );
+	// empty channel list with room for every channel, so playing never allocates
+	static std::vector<SoundSystem::Channel*> MakeChannelList();
 private:
 	UINT32 nBytes = 0u;
 	bool looping = false;
@@ -182,7 +193,8 @@ private:
 	// so these must be mutable
 	mutable std::mutex mutex;
 	mutable std::condition_variable cvDeath;
-	mutable std::vector<SoundSystem::Channel*> activeChannelPtrs;
+	mutable std::vector<SoundSystem::Channel*> activeChannelPtrs = MakeChannelList();
 	static constexpr unsigned int nullSample = 0xFFFFFFFFu;
 	static constexpr float nullSeconds = -1.0f;
-};
\ No newline at end of file
+};
+#endif
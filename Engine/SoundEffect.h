@@ -20,6 +20,8 @@
  ******************************************************************************************/
 #pragma once
 #include "Sound.h"
+// (headless builds get SoundEffect from SilentSound.h through Sound.h)
+#ifdef _WIN32
 #include <random>
 #include <initializer_list>
 #include <memory>
@@ -95,4 +97,5 @@ private:
 	// global default rng for sound effects
 	// not thread safe!
 	static std::mt19937 defaultRng;
-};
\ No newline at end of file
+};
+#endif
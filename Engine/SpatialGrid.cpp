@@ -0,0 +1,95 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+void SpatialGrid::Build( const Vec2* pPositions,int count,float radius )
+{
+	indices.resize( count );
+	pointCells.resize( count );
+	if( count == 0 )
+	{
+		width = height = cellCount = 0;
+		return;
+	}
+
+	// grid covers the bounding box of the points
+	Vec2 lo = pPositions[0];
+	Vec2 hi = pPositions[0];
+	for( int i = 1; i < count; i++ )
+	{
+		lo.x = std::min( lo.x,pPositions[i].x );
+		lo.y = std::min( lo.y,pPositions[i].y );
+		hi.x = std::max( hi.x,pPositions[i].x );
+		hi.y = std::max( hi.y,pPositions[i].y );
+	}
+	origin = lo;
+	// cells smaller than the radius would miss neighbors, and a few stragglers far
+	// away shouldn't blow up the cell count, so grow the cells until it fits
+	cellSize = std::max( radius,1.0f );
+	const float maxCells = float( std::max( count * maxCellsPerPoint,16 ) );
+	const float area = ((hi.x - lo.x) / cellSize + 1.0f) * ((hi.y - lo.y) / cellSize + 1.0f);
+	if( area > maxCells )
+	{
+		cellSize *= std::sqrt( area / maxCells );
+	}
+	invCellSize = 1.0f / cellSize;
+	width = int( (hi.x - lo.x) * invCellSize ) + 1;
+	height = int( (hi.y - lo.y) * invCellSize ) + 1;
+	cellCount = width * height;
+
+	// counting sort of the points by cell
+	cellStarts.assign( cellCount + 1,0 );
+	for( int i = 0; i < count; i++ )
+	{
+		const int cell = GetCellY( pPositions[i].y ) * width + GetCellX( pPositions[i].x );
+		pointCells[i] = cell;
+		cellStarts[cell]++;
+	}
+	// running total, cellStarts[c] is now the end of cell c
+	for( int c = 1; c < cellCount; c++ )
+	{
+		cellStarts[c] += cellStarts[c - 1];
+	}
+	cellStarts[cellCount] = count;
+	// fill back to front, so each cell's run ends up in increasing index order
+	// and cellStarts[c] walks back to the start of cell c
+	for( int i = count - 1; i >= 0; i-- )
+	{
+		indices[--cellStarts[pointCells[i]]] = i;
+	}
+}
+
+void SpatialGrid::Reserve( int maxCount )
+{
+	indices.reserve( maxCount );
+	pointCells.reserve( maxCount );
+	// Build keeps the cell count near the cap (float rounding can push it a
+	// little over), so leave plenty of slack
+	cellStarts.reserve( std::max( maxCount * maxCellsPerPoint,16 ) * 2 + 1 );
+}
+
+int SpatialGrid::FindFirstWithin( const Vec2* pPositions,int self,float radius ) const
+{
+	const Vec2 pos = pPositions[self];
+	int first = -1;
+	ForEachCandidate( pos,
+		[&]( int other )
+		{
+			// don't consider self (cells are in index order, so nothing after the best so far can win)
+			if( other == self || (first >= 0 && other >= first) )
+			{
+				return;
+			}
+			if( (pos - pPositions[other]).GetLengthSq() < radius * radius )
+			{
+				first = other;
+			}
+		}
+	);
+	return first;
+}
+
+float SpatialGrid::GetCellSize() const
+{
+	return cellSize;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Vec2.h"
+#include <algorithm>
+#include <vector>
+
+// uniform grid over a set of points, rebuilt from scratch every frame
+// cells are at least as big as the query radius, so everything within the radius of a
+// point is in the 3x3 block of cells around it
+// (points are counting sorted by cell, so the build is linear and a cell is one
+// contiguous run of indices, in increasing order)
+class SpatialGrid
+{
+public:
+	// radius: the largest distance queries will ask about
+	void Build( const Vec2* pPositions,int count,float radius );
+	// makes room for builds of up to maxCount points, so they never allocate
+	void Reserve( int maxCount );
+	// calls f( index ) for every point that could be within radius of pos (and some that aren't)
+	template<typename F>
+	void ForEachCandidate( const Vec2& pos,F f ) const
+	{
+		if( cellCount == 0 )
+		{
+			return;
+		}
+		const int cx = GetCellX( pos.x );
+		const int cy = GetCellY( pos.y );
+		for( int y = std::max( cy - 1,0 ); y <= std::min( cy + 1,height - 1 ); y++ )
+		{
+			for( int x = std::max( cx - 1,0 ); x <= std::min( cx + 1,width - 1 ); x++ )
+			{
+				const int cell = y * width + x;
+				for( int i = cellStarts[cell]; i < cellStarts[cell + 1]; i++ )
+				{
+					f( indices[i] );
+				}
+			}
+		}
+	}
+	// lowest index other than self whose point is closer than radius to point self, or -1
+	// (pPositions are the points the grid was built from, radius at most the build radius)
+	int FindFirstWithin( const Vec2* pPositions,int self,float radius ) const;
+	float GetCellSize() const;
+private:
+	int GetCellX( float x ) const
+	{
+		return std::min( std::max( int( (x - origin.x) * invCellSize ),0 ),width - 1 );
+	}
+	int GetCellY( float y ) const
+	{
+		return std::min( std::max( int( (y - origin.y) * invCellSize ),0 ),height - 1 );
+	}
+private:
+	// grid never gets more cells than this many per point (spread out sets get bigger cells)
+	static constexpr int maxCellsPerPoint = 4;
+	Vec2 origin = { 0.0f,0.0f };
+	float cellSize = 1.0f;
+	float invCellSize = 1.0f;
+	int width = 0;
+	int height = 0;
+	int cellCount = 0;
+	// cell of every point, then the points of cell c are indices[cellStarts[c]..cellStarts[c + 1])
+	// (kept between builds so steady state doesn't allocate)
+	std::vector<int> pointCells;
+	std::vector<int> cellStarts;
+	std::vector<int> indices;
+};
@@ -2,140 +2,362 @@
 
 #include "Colors.h"
 #include "Graphics.h"
+#include "BlitKernels.h"
+#include <algorithm>
+#include <type_traits>
 
+// sprite effects are called by Graphics::DrawSprite once per row span (not per pixel)
+//	pSrc:    first source pixel of the span
+//	srcStep: how to walk the source (1 for normal, -1 for mirrored)
+//	pDst:    first destination pixel of the span (always walked forward)
+//	n:       number of pixels in the span
+//	yDest:   screen row of the span (for effects that change by scanline)
+//
+// effects are built out of stages chained together in a Pipeline, for example
+//	Pipeline<Stage::Key,Stage::HalfTint,Stage::Dissolve>{ chroma,tint,percent }
+// the chain is resolved at compile time into a single loop over the span
+// (mirroring is not a stage, DrawSprite does it by walking the source backwards)
 namespace SpriteEffect
 {
-	class Chroma
+	namespace Stage
+	{
+		// defaults for the optional parts of a stage
+		// every stage also has bool Pixel( Color& c,const Color* pDst ) const, which
+		// transforms the pixel in c and returns false to drop it (stages after it don't run)
+		// pDst points at the destination pixel, only stages that blend read it (so a key
+		// stage in front can drop the pixel before dst is ever loaded)
+		class Base
+		{
+		public:
+			// true for stages that load the destination pixel in Pixel
+			static constexpr bool readsDst = false;
+			// true for stages whose Pixel can return false (leaving dst untouched)
+			static constexpr bool dropsPixels = false;
+			// false rejects the whole span (decided once per row, not per pixel)
+			bool Row( int /*yDest*/ ) const
+			{
+				return true;
+			}
+		};
+		// drops pixels matching the chroma key
+		class Key : public Base
+		{
+		public:
+			static constexpr bool dropsPixels = true;
+			Key( Color chroma )
+				:
+				chroma( chroma )
+			{}
+			bool Pixel( Color& c,const Color* /*pDst*/ ) const
+			{
+				return c != chroma;
+			}
+			Color GetChroma() const
+			{
+				return chroma;
+			}
+		private:
+			Color chroma;
+		};
+		// replaces the pixel with a single color
+		class Substitute : public Base
+		{
+		public:
+			Substitute( Color sub )
+				:
+				sub( sub )
+			{}
+			bool Pixel( Color& c,const Color* /*pDst*/ ) const
+			{
+				c = sub;
+				return true;
+			}
+		private:
+			Color sub;
+		};
+		// half the pixel plus half the tint
+		class HalfTint : public Base
+		{
+		public:
+			HalfTint( Color tint )
+				:
+				// divide channels by 2 via shift, mask to prevent bleeding between channels
+				tint_pre( (tint.dword >> 1u) & halfMask )
+			{}
+			bool Pixel( Color& c,const Color* /*pDst*/ ) const
+			{
+				c = tint_pre.dword + ((c.dword >> 1u) & halfMask);
+				return true;
+			}
+		private:
+			static constexpr unsigned int halfMask = 0b01111111011111110111111101111111u;
+			Color tint_pre;
+		};
+		// 50/50 blend of the pixel with the screen
+		class Average : public Base
+		{
+		public:
+			static constexpr bool readsDst = true;
+			bool Pixel( Color& c,const Color* pDst ) const
+			{
+				const Color dst = *pDst;
+				c = {
+					(unsigned char)((c.GetR() + dst.GetR()) / 2),
+					(unsigned char)((c.GetG() + dst.GetG()) / 2),
+					(unsigned char)((c.GetB() + dst.GetB()) / 2)
+				};
+				return true;
+			}
+		};
+		// blends premultiplied alpha pixels with the screen (see BlitKernels::AlphaBlend)
+		class BlendBaked : public Base
+		{
+		public:
+			static constexpr bool readsDst = true;
+			static constexpr bool dropsPixels = true;
+			bool Pixel( Color& c,const Color* pDst ) const
+			{
+				const unsigned int cAlpha = 255u - c.GetA();
+				if( cAlpha == 255u )
+				{
+					return false;
+				}
+				const Color dst = *pDst;
+				const unsigned int rb = (((dst.dword & 0xFF00FFu) * cAlpha) >> 8) & 0xFF00FFu;
+				const unsigned int g = (((dst.dword & 0x00FF00u) * cAlpha) >> 8) & 0x00FF00u;
+				c = rb + g + c.dword;
+				return true;
+			}
+		};
+		// dissolves the image by scanline, percent of each band of rows is drawn
+		class Dissolve : public Base
+		{
+		public:
+			Dissolve( float percent )
+				:
+				filled( int( float( height ) * percent ) )
+			{}
+			bool Row( int yDest ) const
+			{
+				// height mask determines frequency of vertical dissolve sections
+				return (yDest & height_mask) < filled;
+			}
+			bool Pixel( Color& /*c*/,const Color* /*pDst*/ ) const
+			{
+				return true;
+			}
+		private:
+			static constexpr int height = 4;
+			static constexpr int height_mask = height - 1;
+			int filled;
+		};
+	}
+
+	namespace Detail
+	{
+		// stages stored one after the other (a plain struct, so effects built from it
+		// stay trivially copyable for the render queue)
+		template<typename... Stages>
+		class Chain;
+		template<typename S>
+		class Chain<S>
+		{
+		public:
+			static constexpr bool readsDst = S::readsDst;
+			static constexpr bool dropsPixels = S::dropsPixels;
+			Chain( S stage )
+				:
+				stage( stage )
+			{}
+			bool Row( int yDest ) const
+			{
+				return stage.Row( yDest );
+			}
+			bool Pixel( Color& c,const Color* pDst ) const
+			{
+				return stage.Pixel( c,pDst );
+			}
+		private:
+			S stage;
+		};
+		template<typename S,typename Next,typename... Rest>
+		class Chain<S,Next,Rest...>
+		{
+		public:
+			static constexpr bool readsDst = S::readsDst || Chain<Next,Rest...>::readsDst;
+			static constexpr bool dropsPixels = S::dropsPixels || Chain<Next,Rest...>::dropsPixels;
+			Chain( S stage,Next next,Rest... rest )
+				:
+				stage( stage ),
+				rest( next,rest... )
+			{}
+			bool Row( int yDest ) const
+			{
+				return stage.Row( yDest ) && rest.Row( yDest );
+			}
+			bool Pixel( Color& c,const Color* pDst ) const
+			{
+				return stage.Pixel( c,pDst ) && rest.Pixel( c,pDst );
+			}
+		private:
+			S stage;
+			Chain<Next,Rest...> rest;
+		};
+	}
+
+	// fused loop over the span running every stage on each pixel
+	template<typename... Stages>
+	class Pipeline
 	{
 	public:
-		Chroma( Color c )
+		Pipeline( Stages... stages )
 			:
-			chroma( c )
+			chain( stages... )
 		{}
-		void operator()( Color cSrc,int xDest,int yDest,Graphics& gfx ) const
+		void operator()( const Color* pSrc,int srcStep,Color* pDst,int n,int yDest ) const
 		{
-			if( cSrc != chroma )
+			if( !chain.Row( yDest ) )
 			{
-				gfx.PutPixel( xDest,yDest,cSrc );
+				return;
 			}
+			Span( pSrc,srcStep,pDst,n,std::integral_constant<bool,
+				Detail::Chain<Stages...>::readsDst || Detail::Chain<Stages...>::dropsPixels>{} );
 		}
 	private:
-		Color chroma;
+		// keyed or blending chains: dropped pixels are never stored, and dst is only loaded
+		// by the stages that blend, after the ones before them passed
+		void Span( const Color* pSrc,int srcStep,Color* pDst,int n,std::true_type ) const
+		{
+			// stages copied to the stack, so stores to dst can't alias them (otherwise every
+			// store makes the compiler load the key and colors again for the next pixel)
+			const Detail::Chain<Stages...> stages = chain;
+			for( int i = 0; i < n; i++,pSrc += srcStep )
+			{
+				Color c = *pSrc;
+				if( stages.Pixel( c,pDst + i ) )
+				{
+					pDst[i] = c;
+				}
+			}
+		}
+		// chains that write every pixel and never read dst: plain store with no branch,
+		// so gcc can vectorize it (dst is never loaded)
+		void Span( const Color* pSrc,int srcStep,Color* pDst,int n,std::false_type ) const
+		{
+			const Detail::Chain<Stages...> stages = chain;
+			for( int i = 0; i < n; i++,pSrc += srcStep )
+			{
+				Color c = *pSrc;
+				stages.Pixel( c,pDst + i );
+				pDst[i] = c;
+			}
+		}
+		Detail::Chain<Stages...> chain;
 	};
-	class Substitution
+	// pipelines that have a simd kernel for the whole span use it instead of the loop
+	// no stages: every pixel copied as is (see IsOpaqueCopy in Graphics.h)
+	template<>
+	class Pipeline<>
 	{
 	public:
-		Substitution( Color c,Color s )
+		static constexpr bool isOpaqueCopy = true;
+		void operator()( const Color* pSrc,int srcStep,Color* pDst,int n,int /*yDest*/ ) const
+		{
+			// row memcpy, simd reverse for mirrored
+			BlitKernels::Copy( pSrc,srcStep,pDst,n );
+		}
+	};
+	template<>
+	class Pipeline<Stage::Key>
+	{
+	public:
+		Pipeline( Stage::Key key )
 			:
-			chroma( c ),
-			sub( s )
+			key( key )
 		{}
-		void operator()( Color cSrc,int xDest,int yDest,Graphics& gfx ) const
+		void operator()( const Color* pSrc,int srcStep,Color* pDst,int n,int /*yDest*/ ) const
 		{
-			if( cSrc != chroma )
-			{
-				gfx.PutPixel( xDest,yDest,sub );
-			}
+			// simd compare and masked store (scalar fallback picked at startup)
+			BlitKernels::Chroma( pSrc,srcStep,pDst,n,key.GetChroma() );
 		}
 	private:
-		Color chroma = Colors::Magenta;
-		Color sub;
+		Stage::Key key;
 	};
-	class Copy
+	template<>
+	class Pipeline<Stage::BlendBaked>
 	{
 	public:
-		void operator()( Color cSrc,int xDest,int yDest,Graphics& gfx ) const
+		Pipeline( Stage::BlendBaked = {} )
+		{}
+		void operator()( const Color* pSrc,int srcStep,Color* pDst,int n,int /*yDest*/ ) const
 		{
-			gfx.PutPixel( xDest,yDest,cSrc );
+			BlitKernels::AlphaBlend( pSrc,srcStep,pDst,n );
 		}
 	};
-	class Ghost
+
+	// the named effects used around the game
+	class Chroma : public Pipeline<Stage::Key>
+	{
+	public:
+		Chroma( Color c )
+			:
+			Pipeline( c )
+		{}
+	};
+	// draws keyed pixels in a single color (text)
+	class Substitution : public Pipeline<Stage::Key,Stage::Substitute>
+	{
+	public:
+		Substitution( Color c,Color s )
+			:
+			Pipeline( c,s )
+		{}
+	};
+	class Copy : public Pipeline<>
+	{};
+	// fills the whole span with a single color
+	// (for compiled sprites, where every pixel handed over is opaque)
+	class Fill : public Pipeline<Stage::Substitute>
+	{
+	public:
+		Fill( Color c )
+			:
+			Pipeline( c )
+		{}
+	};
+	class Ghost : public Pipeline<Stage::Key,Stage::Average>
 	{
 	public:
 		Ghost( Color c )
 			:
-			chroma( c )
+			Pipeline( c,{} )
 		{}
-		void operator()( Color src,int xDest,int yDest,Graphics& gfx ) const
-		{
-			if( src != chroma )
-			{
-				const Color dest = gfx.GetPixel( xDest,yDest );
-				const Color blend = {
-					unsigned char( (src.GetR() + dest.GetR()) / 2 ),
-					unsigned char( (src.GetG() + dest.GetG()) / 2 ),
-					unsigned char( (src.GetB() + dest.GetB()) / 2 )
-				};
-				gfx.PutPixel( xDest,yDest,blend );
-			}
-		}
-	private:
-		Color chroma;
 	};
 	// dissolves image by scanline and blends drawn pixels with a color
 	// good for dying enemies i guess
-	class DissolveHalfTint
+	class DissolveHalfTint : public Pipeline<Stage::Key,Stage::HalfTint,Stage::Dissolve>
 	{
 	public:
 		DissolveHalfTint( Color chroma,Color tint,float percent )
 			:
-			chroma( chroma ),
-			// divide channels by 2 via shift, mask to prevent bleeding between channels
-			tint_pre( (tint.dword >> 1u) & 0b01111111011111110111111101111111u ),
-			filled( int( float( height ) * percent ) )
+			Pipeline( chroma,tint,percent )
 		{}
-		void operator()( Color src,int xDest,int yDest,Graphics& gfx ) const
-		{
-			// height mask determines frequency of vertical dissolve sections
-			if( src != chroma && (yDest & height_mask) < filled )
-			{
-				const Color blend = tint_pre.dword +
-					// divide channels by 2 via shift, mask to prevent bleeding between channels
-					((src.dword >> 1u) & 0b01111111011111110111111101111111u);					
-				gfx.PutPixel( xDest,yDest,blend );
-			}
-		}
-	private:
-		Color chroma;
-		Color tint_pre;
-		static constexpr int height = 4;
-		static constexpr int height_mask = height - 1;
-		int filled;
 	};
 	// blends sprite with whatever is on the screen
 	// using the per-pixel alpha stored in the src pixels
-	class AlphaBlendBaked
-	{
-	public:
-		void operator()( Color src,int xDest,int yDest,Graphics& gfx ) const
-		{
-			// pre-extract alpha complement
-			const int cAlpha = 255 - src.GetA();
-			// reject drawing pixels if alpha == 0 (full transparent)
-			// this will give a huge speedup if there are large sections
-			// of blank space (pretty common), but slower if unpredictable
-			// patters of transparency in a 50/50 mix (not really forseeable)
-			if( cAlpha != 255 )
-			{
-				const Color dst = gfx.GetPixel( xDest,yDest );
-				// blend channels by linear interpolation using integer math
-				// (basic idea: src * alpha + dst * (1.0 - alpha), where alpha is from 0 to 1
-				// we divide by 256 because it can be done with bit shift
-				// it gives us at most 0.4% error, but this is negligible
-				// optimized version has alpha premultiplied in src, all we need to do is
-				// scale dst by calpha and then pack back into dword and add to src dword
-				// there will be no overflow between channels because alpha + calpha == 255
-				//
-				// we can multiply the red and blue channels together in one operation
-				// because the results will not overflow into neighboring channels
-				// after, we shift to divide, and then mask to clear out the shifted garbo
-				// channels are left in their byte position for easy combining with an add
-				const int rb = (((dst.dword & 0xFF00FFu) * cAlpha) >> 8) & 0xFF00FFu;
-				const int g = (((dst.dword & 0x00FF00u) * cAlpha) >> 8) & 0x00FF00u;
-				// add multiplied dst channels together with premultiplied src channels
-				// and write the resulting interpolated color to the screen
-				gfx.PutPixel( xDest,yDest,rb + g + src.dword );
-			}
-		}
-	};
-}
\ No newline at end of file
+	//
+	// blend channels by linear interpolation using integer math
+	// (basic idea: src * alpha + dst * (1.0 - alpha), where alpha is from 0 to 1
+	// we divide by 256 because it can be done with bit shift
+	// it gives us at most 0.4% error, but this is negligible
+	// optimized version has alpha premultiplied in src, all we need to do is
+	// scale dst by calpha and then pack back into dword and add to src dword
+	// there will be no overflow between channels because alpha + calpha == 255
+	//
+	// the scalar kernel multiplies the red and blue channels together in one operation
+	// because the results will not overflow into neighboring channels, the simd kernels
+	// widen channels to 16 bits and do 4/8 pixels at once, skipping blocks that are
+	// fully transparent (nothing to do) or fully opaque (straight copy of src)
+	class AlphaBlendBaked : public Pipeline<Stage::BlendBaked>
+	{};
+}
@@ -1,108 +1,65 @@
 #include "Surface.h"
-// gdiplus needs a lot of dumb windows shit
-// enable that shit for this translation unit only
-#define FULL_WINTARD
-#include "ChiliWin.h"
+#include "SurfaceCache.h"
+#include "ChiliMemory.h"
+#include "ColorConvert.h"
 #include <algorithm>
-// gdiplus needs min/max, but we disable that (even in
-// full wintard mode), so we need to inject min/max into
-// the Gdiplus namespace
-namespace Gdiplus
-{
-	using std::min;
-	using std::max;
-}
-#include <gdiplus.h>
 #include <cassert>
-#include <fstream>
-
-namespace gdi = Gdiplus;
+#include <cstring>
+#include <new>
 
 Surface::Surface( const std::wstring& filename )
-{	
-	// filename must be at least 4 chars long
-	if( filename.length() < 4 )
-	{
-		// generate narrow string of filename
-		std::string narrow( filename.begin(),filename.end() );
-		throw std::runtime_error( "Surface::Surface bad file name: " + narrow );
-	}
-
-	// open image file with gdiplus (not only .bmp files)
-	gdi::Bitmap bitmap( filename.c_str() );
-
-	// check if file loaded successfully, throw exception if didn't
-	if( bitmap.GetLastStatus() != gdi::Ok )
-	{
-		// generate narrow string of filename
-		std::string narrow( filename.begin(),filename.end() );
-		// throw exception with error message
-		// could possibly add more info with lookup of error code name / desc
-		// but I don't want to right now cuz im lazy
-		throw std::runtime_error( "Surface::Surface failed to load file: " + narrow );
-	}
-
-	// allocate Surface resources and set dimensions
-	width = bitmap.GetWidth();
-	height = bitmap.GetHeight();
-	pPixels = new Color[width * height];
-	
-	// test if pixel format is alpha, and save result
-	const bool isAlpha = gdi::IsAlphaPixelFormat( bitmap.GetPixelFormat() ) == TRUE;
-
-	// loop through image dimensions, copy from gdip bitmap to surface
-	for( int y = 0; y < height; y++ )
-	{
-		for( int x = 0; x < width; x++ )
-		{
-			// need this to receive color of pixel
-			gdi::Color pixel;
-			// read color from gdip bitmap
-			bitmap.GetPixel( x,y,&pixel );
-			// write to surface (with alpha channel if exists)
-			if( isAlpha )
-			{
-				PutPixel( x,y,{ pixel.GetA(),pixel.GetR(),pixel.GetG(),pixel.GetB() } );
-			}
-			else
-			{
-				PutPixel( x,y,{ pixel.GetR(),pixel.GetG(),pixel.GetB() } );
-			}
-		}
-	}
-
-	// check to see whether filename starts with "pm_"
-	// (actually, being lazy so only checking if contains "pm_")
-	// if so, gotta bake that alpha yo
-	if( filename.find( L"pm_" ) != std::wstring::npos )
-	{
-		BakeAlpha();
-	}
+	:
+	// mapped from the surface cache, or decoded (and baked) if the cache is stale
+	Surface( SurfaceCache::Load( filename ) )
+{
 }
 
 Surface::Surface( int width,int height )
+{
+	Allocate( width,height );
+}
+
+Surface::Surface( Color* pPixels,int width,int height,int pitch,std::shared_ptr<void> pBacking )
 	:
+	pPixels( pPixels ),
 	width( width ),
 	height( height ),
-	pPixels( new Color[width*height] )
+	pitch( pitch ),
+	ownsPixels( false ),
+	pBacking( std::move( pBacking ) )
 {
+	assert( pitch >= width );
 }
 
 Surface::Surface( const Surface& rhs )
+{
+	// copy is always an owning surface, even if rhs is a view
+	Allocate( rhs.width,rhs.height );
+	CopyPixels( rhs );
+}
+
+Surface::Surface( Surface&& donor ) noexcept
 	:
-	Surface( rhs.width,rhs.height )
+	pPixels( donor.pPixels ),
+	width( donor.width ),
+	height( donor.height ),
+	pitch( donor.pitch ),
+	ownsPixels( donor.ownsPixels ),
+	pBacking( std::move( donor.pBacking ) )
 {
-	const int nPixels = width * height;
-	for( int i = 0; i < nPixels; i++ )
-	{
-		pPixels[i] = rhs.pPixels[i];
-	}
+	// leave donor empty (and not owning anything)
+	donor.pPixels = nullptr;
+	donor.width = 0;
+	donor.height = 0;
+	donor.pitch = 0;
+	donor.ownsPixels = false;
+	// (its mirror is of pixels it no longer has)
+	donor.mirror.Reset();
 }
 
 Surface::~Surface()
 {
-	delete [] pPixels;
-	pPixels = nullptr;
+	Free();
 }
 
 Surface& Surface::operator=( const Surface& rhs )
@@ -110,17 +67,36 @@ Surface& Surface::operator=( const Surface& rhs )
 	// prevent self assignment
 	if( this != &rhs )
 	{
-		width = rhs.width;
-		height = rhs.height;
-
-		delete[] pPixels;
-		pPixels = new Color[width*height];
-
-		const int nPixels = width * height;
-		for( int i = 0; i < nPixels; i++ )
+		// keep the buffer if it is already the right size
+		if( !ownsPixels || width != rhs.width || height != rhs.height )
 		{
-			pPixels[i] = rhs.pPixels[i];
+			Free();
+			Allocate( rhs.width,rhs.height );
 		}
+		mirror.Reset();
+		CopyPixels( rhs );
+	}
+	return *this;
+}
+
+Surface& Surface::operator=( Surface&& donor ) noexcept
+{
+	if( this != &donor )
+	{
+		Free();
+		mirror.Reset();
+		pPixels = donor.pPixels;
+		width = donor.width;
+		height = donor.height;
+		pitch = donor.pitch;
+		ownsPixels = donor.ownsPixels;
+		pBacking = std::move( donor.pBacking );
+		donor.pPixels = nullptr;
+		donor.width = 0;
+		donor.height = 0;
+		donor.pitch = 0;
+		donor.ownsPixels = false;
+		donor.mirror.Reset();
 	}
 	return *this;
 }
@@ -131,7 +107,8 @@ void Surface::PutPixel( int x,int y,Color c )
 	assert( x < width );
 	assert( y >= 0 );
 	assert( y < height );
-	pPixels[y * width + x] = c;
+	mirror.Reset();
+	pPixels[y * pitch + x] = c;
 }
 
 Color Surface::GetPixel( int x,int y ) const
@@ -140,7 +117,23 @@ Color Surface::GetPixel( int x,int y ) const
 	assert( x < width );
 	assert( y >= 0 );
 	assert( y < height );
-	return pPixels[y * width + x];
+	return pPixels[y * pitch + x];
+}
+
+Color* Surface::GetRowPtr( int y )
+{
+	assert( y >= 0 );
+	assert( y < height );
+	// caller can write through the pointer
+	mirror.Reset();
+	return pPixels + y * pitch;
+}
+
+const Color* Surface::GetRowPtr( int y ) const
+{
+	assert( y >= 0 );
+	assert( y < height );
+	return pPixels + y * pitch;
 }
 
 int Surface::GetWidth() const
@@ -153,6 +146,11 @@ int Surface::GetHeight() const
 	return height;
 }
 
+int Surface::GetPitch() const
+{
+	return pitch;
+}
+
 RectI Surface::GetRect() const
 {
 	return{ 0,width,0,height };
@@ -160,16 +158,70 @@ RectI Surface::GetRect() const
 
 void Surface::BakeAlpha()
 {
-	const int nPixels = GetWidth() * GetHeight();
-	for( int i = 0; i < nPixels; i++ )
+	// premulitply alpha time each channel (simd, row at a time since rows are padded)
+	for( int y = 0; y < height; y++ )
+	{
+		ColorConvert::Premultiply( pPixels + y * pitch,width );
+	}
+	mirror.Reset();
+}
+
+const Surface* Surface::GetMirrored() const
+{
+	return mirror.Get( sizeof( Color ) * width * height,[this]()
+	{
+		Surface m( width,height );
+		for( int y = 0; y < height; y++ )
+		{
+			std::reverse_copy( GetRowPtr( y ),GetRowPtr( y ) + width,m.GetRowPtr( y ) );
+		}
+		return m;
+	} );
+}
+
+void Surface::Allocate( int width_in,int height_in )
+{
+	width = width_in;
+	height = height_in;
+	// pad rows out so every row starts on a rowAlignment boundary
+	constexpr int pixelsPerAlign = rowAlignment / int( sizeof( Color ) );
+	pitch = (width + pixelsPerAlign - 1) / pixelsPerAlign * pixelsPerAlign;
+	pPixels = static_cast<Color*>( aligned_malloc( sizeof( Color ) * std::max( pitch * height,1 ),rowAlignment ) );
+	if( pPixels == nullptr )
+	{
+		throw std::bad_alloc();
+	}
+	ownsPixels = true;
+}
+
+void Surface::Free()
+{
+	if( ownsPixels )
+	{
+		aligned_free( pPixels );
+	}
+	pPixels = nullptr;
+	ownsPixels = false;
+	pBacking.reset();
+}
+
+void Surface::CopyPixels( const Surface& src )
+{
+	assert( width == src.width && height == src.height );
+	// both padded the same way, whole block in one go
+	if( pitch == src.pitch )
+	{
+		// (src may be a view, so stop at the end of its last row, not its last pitch)
+		if( height > 0 )
+		{
+			memcpy( pPixels,src.pPixels,sizeof( Color ) * (pitch * (height - 1) + width) );
+		}
+	}
+	else
 	{
-		auto pix = pPixels[i];
-		const int alpha = pix.GetA();
-		// premulitply alpha time each channel
-		pix.SetR( (pix.GetR() * alpha) / 256 );
-		pix.SetG( (pix.GetG() * alpha) / 256 );
-		pix.SetB( (pix.GetB() * alpha) / 256 );
-		// write back to surface
-		pPixels[i] = pix;
+		for( int y = 0; y < height; y++ )
+		{
+			memcpy( pPixels + y * pitch,src.pPixels + y * src.pitch,sizeof( Color ) * width );
+		}
 	}
 }
@@ -3,6 +3,8 @@
 #include "Colors.h"
 #include <string>
 #include "Rect.h"
+#include "MirrorCache.h"
+#include <memory>
 
 class Surface
 {
@@ -11,19 +13,50 @@ public:
 	// will trigger alpha premultiply 'baking'
 	Surface( const std::wstring& filename );
 	Surface( int width,int height );
+	// non-owning view of pixels somewhere else (e.g. a region of an atlas page or a mapped cache file)
+	// pitch is the distance between rows in pixels, the memory must outlive the view
+	// unless pBacking is given, which is kept alive for as long as the view (e.g. a mapped file)
+	Surface( Color* pPixels,int width,int height,int pitch,std::shared_ptr<void> pBacking = nullptr );
 	Surface( const Surface& );
+	// moved-from surface is left empty (0x0)
+	// (noexcept so std::vector moves surfaces when it grows instead of copying them)
+	Surface( Surface&& donor ) noexcept;
 	~Surface();
 	Surface& operator=( const Surface& );
+	Surface& operator=( Surface&& donor ) noexcept;
 	void PutPixel( int x,int y,Color c );
 	Color GetPixel( int x,int y ) const;
+	// pointer to the first pixel of row y (pixels within a row are contiguous,
+	// rows themselves are GetPitch() pixels apart)
+	Color* GetRowPtr( int y );
+	const Color* GetRowPtr( int y ) const;
 	int GetWidth() const;
 	int GetHeight() const;
+	int GetPitch() const;
 	RectI GetRect() const;
 	// this function performs alpha premultiplication
 	// which enables more efficient alpha blending
 	void BakeAlpha();
+	// horizontally flipped copy of the whole surface, built on first use and dropped
+	// when the surface is changed (nullptr if it doesn't fit in the MirrorBudget)
+	const Surface* GetMirrored() const;
 private:
+	// allocate owned storage with padded, aligned rows
+	void Allocate( int width,int height );
+	// release owned storage (views are just forgotten)
+	void Free();
+	// copy pixels of a surface of the same dimensions
+	void CopyPixels( const Surface& src );
+private:
+	// owned rows start on this boundary (bytes), so simd kernels can use aligned loads
+	static constexpr int rowAlignment = 64;
 	Color* pPixels = nullptr;
-	int width;
-	int height;
+	int width = 0;
+	int height = 0;
+	int pitch = 0;
+	// false for views
+	bool ownsPixels = true;
+	// whatever holds the pixels of a view (can be empty)
+	std::shared_ptr<void> pBacking;
+	MirrorCache<Surface> mirror;
 };
\ No newline at end of file
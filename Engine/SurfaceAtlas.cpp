@@ -0,0 +1,117 @@
+#include "SurfaceAtlas.h"
+#include "Codex.h"
+#include "ChiliMemory.h"
+#include <algorithm>
+#include <stdexcept>
+
+SurfaceAtlas::SurfaceAtlas( const std::vector<std::wstring>& filenames )
+{
+	// load all images normally first
+	// (images already in the codex stay where they are, anything may be pointing at them)
+	for( const auto& f : filenames )
+	{
+		if( !Codex<Surface>::Contains( f ) && std::find( keys.begin(),keys.end(),f ) == keys.end() )
+		{
+			keys.push_back( f );
+		}
+	}
+	std::vector<Surface> images;
+	images.reserve( keys.size() );
+	for( const auto& k : keys )
+	{
+		images.emplace_back( k );
+	}
+	const std::vector<Placement> placements = Pack( images );
+	// allocate pages
+	for( auto& p : pages )
+	{
+		p.pPixels = static_cast<Color*>( aligned_malloc( GetAllocatedBytes( p ),pageAlignment ) );
+		if( p.pPixels == nullptr )
+		{
+			// destructor won't run if we throw from here
+			for( auto& q : pages )
+			{
+				aligned_free( q.pPixels );
+			}
+			throw std::runtime_error( "SurfaceAtlas::SurfaceAtlas failed to allocate atlas page" );
+		}
+	}
+	// copy images into the pages and hand views of them to the codex
+	for( size_t i = 0; i < images.size(); i++ )
+	{
+		const Surface& img = images[i];
+		const Placement& pl = placements[i];
+		Color* const pOrigin = pages[pl.page].pPixels + pl.offset;
+		for( int y = 0; y < img.GetHeight(); y++ )
+		{
+			Color* const pRow = pOrigin + size_t( y ) * pl.pitch;
+			std::copy( img.GetRowPtr( y ),img.GetRowPtr( y ) + img.GetWidth(),pRow );
+			// padding zeroed so the pages hold no uninitialized memory
+			std::fill( pRow + img.GetWidth(),pRow + pl.pitch,Color( 0u ) );
+		}
+		Codex<Surface>::Insert( keys[i],new Surface( pOrigin,img.GetWidth(),img.GetHeight(),pl.pitch ) );
+		usedPixels += size_t( img.GetWidth() ) * img.GetHeight();
+	}
+}
+
+SurfaceAtlas::~SurfaceAtlas()
+{
+	for( const auto& k : keys )
+	{
+		Codex<Surface>::Remove( k );
+	}
+	for( auto& p : pages )
+	{
+		aligned_free( p.pPixels );
+	}
+}
+
+int SurfaceAtlas::GetPageCount() const
+{
+	return int( pages.size() );
+}
+
+size_t SurfaceAtlas::GetPageBytes() const
+{
+	size_t bytes = 0;
+	for( const auto& p : pages )
+	{
+		bytes += GetAllocatedBytes( p );
+	}
+	return bytes;
+}
+
+float SurfaceAtlas::GetOccupancy() const
+{
+	const size_t total = GetPageBytes() / sizeof( Color );
+	return total != 0 ? float( usedPixels ) / float( total ) : 0.0f;
+}
+
+std::vector<SurfaceAtlas::Placement> SurfaceAtlas::Pack( const std::vector<Surface>& images )
+{
+	std::vector<Placement> placements( images.size() );
+	constexpr size_t pixelsPerRowAlign = rowAlignment / sizeof( Color );
+	constexpr size_t pixelsPerPage = pageBytes / sizeof( Color );
+	for( size_t i = 0; i < images.size(); i++ )
+	{
+		const Surface& img = images[i];
+		const int pitch = int( (size_t( img.GetWidth() ) + pixelsPerRowAlign - 1) / pixelsPerRowAlign * pixelsPerRowAlign );
+		const size_t size = size_t( pitch ) * img.GetHeight();
+		// start new page when the image doesn't fit (an image bigger than a page gets its own)
+		if( pages.empty() || (pages.back().size != 0 && pages.back().size + size > pixelsPerPage) )
+		{
+			pages.push_back( { nullptr,0 } );
+		}
+		// images are whole rows, so the end of the previous one is already row aligned
+		placements[i] = { int( pages.size() ) - 1,pages.back().size,pitch };
+		pages.back().size += size;
+	}
+	return placements;
+}
+
+size_t SurfaceAtlas::GetAllocatedBytes( const Page& page )
+{
+	// round up to a whole number of memory pages
+	const size_t bytes = std::max( sizeof( Color ) * page.size,size_t( 1 ) );
+	return (bytes + pageAlignment - 1) / pageAlignment * pageAlignment;
+}
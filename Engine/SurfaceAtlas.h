@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Surface.h"
+#include "Colors.h"
+#include <vector>
+#include <string>
+
+// packs images into a few big page-aligned atlas pages so the pixels of all sprites
+// sit together in memory instead of in separate heap blocks
+// the packed images are put into Codex<Surface> as views into the pages, so anything
+// retrieving them from the codex afterwards gets the atlas-backed surface
+// (build it before anything retrieves those images, the atlas must outlive the users,
+// images that are already in the codex are left where they are and not packed)
+//
+// images are laid one after the other, each keeping its own (row aligned) pitch, rather
+// than side by side in 2d: nothing here samples the page as a texture, and rows as wide
+// as the page would spread every short sprite over as many memory pages as it has rows
+class SurfaceAtlas
+{
+private:
+	// where an image was put
+	class Placement
+	{
+	public:
+		int page;
+		// pixels from the start of the page
+		size_t offset;
+		int pitch;
+	};
+	class Page
+	{
+	public:
+		Color* pPixels;
+		// pixels in use
+		size_t size;
+	};
+public:
+	SurfaceAtlas( const std::vector<std::wstring>& filenames );
+	SurfaceAtlas( const SurfaceAtlas& ) = delete;
+	SurfaceAtlas& operator=( const SurfaceAtlas& ) = delete;
+	// removes the atlas images from the codex and frees the pages
+	~SurfaceAtlas();
+	int GetPageCount() const;
+	// total bytes of page memory
+	size_t GetPageBytes() const;
+	// fraction of page memory that holds image pixels (0 to 1), the rest is row padding
+	// and the unused end of each page
+	float GetOccupancy() const;
+private:
+	// images go into the current page in order, a new page is started when one doesn't fit
+	std::vector<Placement> Pack( const std::vector<Surface>& images );
+	// page memory actually allocated for a page (whole memory pages)
+	static size_t GetAllocatedBytes( const Page& page );
+private:
+	std::vector<Page> pages;
+	// keys this atlas put into the codex (one per packed image, in packing order)
+	std::vector<std::wstring> keys;
+	size_t usedPixels = 0;
+	// pages hold at most this many bytes of images (unless a single image is bigger)
+	static constexpr size_t pageBytes = 1024u * 1024u;
+	static constexpr size_t pageAlignment = 4096;
+	// every row of every image starts on this boundary (bytes), just like the rows of an
+	// owned Surface, so the simd kernels see the same alignment either way
+	static constexpr size_t rowAlignment = 64;
+};
@@ -0,0 +1,187 @@
+#include "SurfaceCache.h"
+#include "ImageFile.h"
+#include "MappedFile.h"
+#include "FilePath.h"
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#ifdef _WIN32
+// MoveFileEx is in the stuff ChiliWin.h normally strips out
+#define FULL_WINTARD
+#include "ChiliWin.h"
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	class Header
+	{
+	public:
+		char magic[4];
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		// row pitch in pixels
+		uint32_t pitch;
+		uint32_t reserved;
+		// size and modification time (see GetSourceStamp) of the source image the cache was built from
+		uint64_t sourceSize;
+		uint64_t sourceTime;
+		// pixels start 64 bytes in, so rows stay aligned in the (page aligned) mapping
+		unsigned char padding[24];
+	};
+	static_assert( sizeof( Header ) == 64,"cache header must be 64 bytes" );
+
+	constexpr char cacheMagic[4] = { 'S','U','R','F' };
+	// bump when the layout or the stamp changes (old caches are then rebuilt)
+	// 2: source time went from whole seconds to full resolution
+	constexpr uint32_t cacheVersion = 2u;
+
+	// false if the source file doesn't exist
+	// time is the modification time at the full resolution the filesystem keeps
+	// (100 ns ticks on windows, ns elsewhere), whole seconds would miss an image
+	// saved twice within the same second with the same size
+	bool GetSourceStamp( const std::wstring& filename,uint64_t& size,uint64_t& time )
+	{
+#ifdef _WIN32
+		WIN32_FILE_ATTRIBUTE_DATA attr;
+		if( !GetFileAttributesExW( filename.c_str(),GetFileExInfoStandard,&attr ) )
+		{
+			return false;
+		}
+		size = (uint64_t( attr.nFileSizeHigh ) << 32) | attr.nFileSizeLow;
+		time = (uint64_t( attr.ftLastWriteTime.dwHighDateTime ) << 32) | attr.ftLastWriteTime.dwLowDateTime;
+#else
+		struct stat st;
+		if( stat( ToNarrowPath( filename ).c_str(),&st ) != 0 )
+		{
+			return false;
+		}
+		size = uint64_t( st.st_size );
+		time = uint64_t( st.st_mtim.tv_sec ) * 1000000000u + uint64_t( st.st_mtim.tv_nsec );
+#endif
+		return true;
+	}
+
+	bool IsValid( const MappedFile& file,uint64_t sourceSize,uint64_t sourceTime )
+	{
+		if( file.GetSize() < sizeof( Header ) )
+		{
+			return false;
+		}
+		Header h;
+		memcpy( &h,file.GetData(),sizeof( h ) );
+		// dimensions are bounded like ImageFile bounds its headers (maxDimension is a multiple
+		// of the row alignment, so a padded pitch never exceeds it either), which keeps them
+		// well inside int and the pixel byte count well inside 64 bits
+		const uint32_t maxDimension = uint32_t( ImageFile::maxDimension );
+		if( memcmp( h.magic,cacheMagic,sizeof( cacheMagic ) ) != 0 ||
+			h.version != cacheVersion ||
+			h.sourceSize != sourceSize ||
+			h.sourceTime != sourceTime ||
+			h.width == 0u || h.height == 0u ||
+			h.width > maxDimension || h.height > maxDimension ||
+			h.pitch < h.width || h.pitch > maxDimension )
+		{
+			return false;
+		}
+		const uint64_t pixelBytes = uint64_t( sizeof( Color ) ) * h.pitch * h.height;
+		return uint64_t( file.GetSize() - sizeof( Header ) ) >= pixelBytes;
+	}
+
+	// the cache is written to a temp file that is then renamed over the real one,
+	// so a crash (or another instance writing at the same time) can never leave a
+	// half written cache where Load will find it
+	// failing to write the cache is not an error, it just gets decoded again next time
+	void Write( const std::wstring& cacheName,const Surface& s,uint64_t sourceSize,uint64_t sourceTime )
+	{
+#ifdef _WIN32
+		const std::wstring tempName = cacheName + L"." + std::to_wstring( GetCurrentProcessId() ) + L".tmp";
+		std::ofstream file( tempName,std::ios::binary | std::ios::trunc );
+#else
+		const std::wstring tempName = cacheName + L"." + std::to_wstring( getpid() ) + L".tmp";
+		std::ofstream file( ToNarrowPath( tempName ),std::ios::binary | std::ios::trunc );
+#endif
+		if( !file )
+		{
+			return;
+		}
+		Header h = {};
+		memcpy( h.magic,cacheMagic,sizeof( cacheMagic ) );
+		h.version = cacheVersion;
+		h.width = uint32_t( s.GetWidth() );
+		h.height = uint32_t( s.GetHeight() );
+		h.pitch = uint32_t( s.GetPitch() );
+		h.sourceSize = sourceSize;
+		h.sourceTime = sourceTime;
+		file.write( reinterpret_cast<const char*>( &h ),sizeof( h ) );
+		// padding at the end of each row is written as zeros
+		std::vector<Color> row( s.GetPitch() );
+		for( int y = 0; y < s.GetHeight(); y++ )
+		{
+			std::copy( s.GetRowPtr( y ),s.GetRowPtr( y ) + s.GetWidth(),row.begin() );
+			file.write( reinterpret_cast<const char*>( row.data() ),sizeof( Color ) * row.size() );
+		}
+		file.close();
+#ifdef _WIN32
+		// (replacing fails if another instance has the old cache mapped, it'll just be rebuilt later)
+		if( !file || !MoveFileExW( tempName.c_str(),cacheName.c_str(),MOVEFILE_REPLACE_EXISTING ) )
+		{
+			DeleteFileW( tempName.c_str() );
+		}
+#else
+		if( !file || std::rename( ToNarrowPath( tempName ).c_str(),ToNarrowPath( cacheName ).c_str() ) != 0 )
+		{
+			std::remove( ToNarrowPath( tempName ).c_str() );
+		}
+#endif
+	}
+}
+
+Surface SurfaceCache::Load( const std::wstring& filename )
+{
+	const std::wstring cacheName = filename + L".surf";
+	uint64_t sourceSize = 0u;
+	uint64_t sourceTime = 0u;
+	const bool haveSource = GetSourceStamp( filename,sourceSize,sourceTime );
+	if( haveSource )
+	{
+		try
+		{
+			auto pFile = std::make_shared<MappedFile>( cacheName );
+			if( IsValid( *pFile,sourceSize,sourceTime ) )
+			{
+				Header h;
+				memcpy( &h,pFile->GetData(),sizeof( h ) );
+				Color* const pPixels = reinterpret_cast<Color*>( pFile->GetData() + sizeof( Header ) );
+				// surface keeps the mapping alive
+				return Surface( pPixels,int( h.width ),int( h.height ),int( h.pitch ),std::move( pFile ) );
+			}
+		}
+		catch( const std::runtime_error& )
+		{
+			// no cache file yet
+		}
+	}
+	// cache miss (ImageFile reports a missing source)
+	Surface s = ImageFile::Load( filename );
+	// check to see whether filename starts with "pm_"
+	// (actually, being lazy so only checking if contains "pm_")
+	// if so, gotta bake that alpha yo
+	if( filename.find( L"pm_" ) != std::wstring::npos )
+	{
+		s.BakeAlpha();
+	}
+	if( haveSource )
+	{
+		Write( cacheName,s,sourceSize,sourceTime );
+	}
+	return s;
+}
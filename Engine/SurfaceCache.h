@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Surface.h"
+#include <string>
+
+// on-disk cache of decoded images, stored next to the source image as <filename>.surf
+// a cache file is a small header followed by the pixels laid out exactly like a Surface
+// (alpha already baked for pm_ files, rows padded out to the pitch), so a hit is just
+// a memory map of the file with the surface viewing straight into it (no decode, no copy)
+// the cache is rebuilt when the size or (full resolution) modification time of the source image changes
+namespace SurfaceCache
+{
+	// map the cached image, or decode it (and write the cache) if there is no valid cache
+	Surface Load( const std::wstring& filename );
+}
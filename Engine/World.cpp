@@ -46,117 +46,155 @@ const std::string layer2 =
 World::World( const RectI& screenRect )
 	:
 	bg1( screenRect,25,19,layer1 ),
-	bg2( screenRect,25,19,layer2 )
+	bg2( screenRect,25,19,layer2 ),
+	poos( maxPoos ),
+	bullets( maxBullets )
 {
+	targetCenters.reserve( maxPoos );
+	targetPoos.reserve( maxPoos );
+	pooHitGrid.Reserve( maxPoos );
+	bulletHits.reserve( maxBullets );
+	// one extra count for the bullets that hit nothing
+	hitCounts.reserve( maxPoos + 1 );
+
 	bgm.Play( 1.0f,0.6f );
 	std::uniform_real_distribution<float> xd( 0,800 );
 	std::uniform_real_distribution<float> yd( 0,600 );
-	for( int n = 0; n < 12; n++ )
+	for( int n = 0; n < maxPoos; n++ )
 	{
-		poos.emplace_back( Vec2{ xd( rng ),yd( rng ) } );
+		poos.Spawn( Vec2{ xd( rng ),yd( rng ) } );
 	}
 }
 void World::HandleInput( Keyboard& kbd,Mouse& mouse )
 {
 	chili.HandleInput( kbd,mouse,*this );
 	// independent poo that don't need no World to tell her what to do!
-	for( auto& poo : poos )
-	{
-		poo.ProcessLogic( *this );
-	}
+	poos.ProcessLogic( *this );
 }
 
 void World::Update( float dt )
 {
 	chili.Update( *this,dt );
 	
-	for( auto& b : bullets )
+	bullets.Update( dt );
+
+	// update the poos and do poo collision with chili
+	poos.Update( *this,dt );
+	// (the live ones are noted down as bullet targets for the broadphase below)
+	targetCenters.clear();
+	targetPoos.clear();
+	const auto chili_hitbox = chili.GetHitbox();
+	for( int i = 0; i < poos.GetCount(); i++ )
 	{
-		b.Update( dt );
-	}
-
-	// update the poos and do poo collision with chili and bullets
-	// AND do bullet removal due to collision with poo
-	// (I don't like that we are doing so many collisions in here, but we'll see...
-	// also mixing cleanup in here when most of it is done at the end)
-	for( auto& poo : poos )
-	{
-		poo.Update( *this,dt );
-
 		// here we have tests for collision between poo and bullet/chili
 		// only do tests if poo is alive
-		if( !poo.IsDead() )
+		if( !poos.IsDead( i ) )
 		{
-			// calculate the poo hitbox once here
-			const auto poo_hitbox = poo.GetHitbox();
 			// chili take damage if collide with poo
-			// a little redundancy here in generating same chili hitbox for each poo
-			// but do we really care? (naw son)
-			if( !chili.IsInvincible() && chili.GetHitbox().IsOverlappingWith( poo_hitbox ) )
+			if( !chili.IsInvincible() && chili_hitbox.IsOverlappingWith( poos.GetHitbox( i ) ) )
 			{
 				chili.ApplyDamage();
 			}
+			targetCenters.push_back( poos.GetPos( i ) );
+			targetPoos.push_back( i );
+		}
+	}
 
-			// remove all bullets colliding with current poo
-			remove_erase_if( bullets,
-				// capture poo so we can damage it on bullet collision
-				[&poo,&poo_hitbox]( const Bullet& b )
+	CollideBulletsWithPoos();
+
+	// remove all poos ready for removal
+	poos.RemoveFinished();
+}
+
+void World::CollideBulletsWithPoos()
+{
+	// broadphase: a bullet can only touch live poos whose center is within both
+	// hitbox half widths of its own, which is the 3x3 grid cells around it
+	static_assert( PooStore::hitbox_halfwidth >= PooStore::hitbox_halfheight &&
+		BulletStore::hitbox_halfwidth >= BulletStore::hitbox_halfheight,
+		"grid cells must span the longer side of the hitboxes" );
+	pooHitGrid.Build( targetCenters.data(),int( targetCenters.size() ),
+		PooStore::hitbox_halfwidth + BulletStore::hitbox_halfwidth );
+	const int noHit = int( targetPoos.size() );
+	bulletHits.resize( bullets.GetCount() );
+	for( int b = 0; b < bullets.GetCount(); b++ )
+	{
+		// a bullet goes into the first poo (in poo order) it overlaps, so that is
+		// the lowest target index among the candidates
+		const auto bullet_hitbox = bullets.GetHitbox( b );
+		int hit = noHit;
+		pooHitGrid.ForEachCandidate( bullets.GetPos( b ),
+			[&]( int t )
+			{
+				if( t < hit && bullet_hitbox.IsOverlappingWith( poos.GetHitbox( targetPoos[t] ) ) )
 				{
-					if( b.GetHitbox().IsOverlappingWith( poo_hitbox ) )
-					{
-						// this lambda predicate has side effect of damaging poos
-						// when a collision is detected
-						poo.ApplyDamage( 35.0f );
-						return true;
-					}
-					return false;
+					hit = t;
 				}
-			);
+			}
+		);
+		bulletHits[b] = hit;
+	}
+
+	// damage in poo order, once for every bullet that went in
+	hitCounts.assign( noHit + 1,0 );
+	for( int hit : bulletHits )
+	{
+		hitCounts[hit]++;
+	}
+	for( int t = 0; t < noHit; t++ )
+	{
+		for( int i = 0; i < hitCounts[t]; i++ )
+		{
+			poos.ApplyDamage( targetPoos[t],35.0f );
 		}
 	}
 
-	// remove all poos ready for removal
-	remove_erase_if( poos,std::mem_fn( &Poo::IsReadyForRemoval ) );
-
-	// remove all oob fballs
-	remove_erase_if( bullets,
-		// precalculate oob box
-		// offset upwards to account for bullet 'height' (nasty hack?)
-		[bound_rect = bounds.GetRect().GetDisplacedBy( { 0.0f,-10.0f } )]
-		( const Bullet& b )
+	// one compaction pass for bullets that hit something and oob fballs
+	// precalculate oob box
+	// offset upwards to account for bullet 'height' (nasty hack?)
+	const auto bound_rect = bounds.GetRect().GetDisplacedBy( { 0.0f,-10.0f } );
+	bullets.RemoveIf(
+		[&]( int b )
 		{
-			return !b.GetHitbox().IsOverlappingWith( bound_rect );
+			return bulletHits[b] != noHit || !bullets.GetHitbox( b ).IsOverlappingWith( bound_rect );
 		}
 	);
 }
 
-void World::Draw( Graphics& gfx ) const
+void World::Draw( RenderQueue& rq ) const
 {
 	// draw scenery underlayer
-	bg1.Draw( gfx );
+	bg1.Draw( rq,RenderQueue::Layer::Underlay );
 
-	for( const auto& poo : poos )
-	{
-		poo.Draw( gfx );
-	}
+	// entities key themselves by their y position, so the queue sorts
+	// them back to front regardless of the order they are submitted in
+	poos.Draw( rq );
 
-	chili.Draw( gfx );
+	chili.Draw( rq );
 
-	for( const auto& b : bullets )
-	{
-		b.Draw( gfx );
-	}
+	bullets.Draw( rq );
 
 	// draw scenery overlayer
-	bg2.Draw( gfx );
+	bg2.Draw( rq,RenderQueue::Layer::Overlay );
+}
+
+bool World::Covers( const RectI& rect ) const
+{
+	return bg1.Covers( rect );
+}
+
+int World::GetMaxDrawCount() const
+{
+	// one draw per poo and bullet
+	return bg1.GetDrawCount() + maxPoos + Chili::maxDraws + maxBullets + bg2.GetDrawCount();
 }
 
-void World::SpawnBullet( Bullet bullet )
+void World::SpawnBullet( const Vec2& pos,const Vec2& dir )
 {
-	bullets.push_back( bullet );
+	bullets.Spawn( pos,dir );
 }
 
-const std::vector<Poo>& World::GetPoosConst() const
+const PooStore& World::GetPoosConst() const
 {
 	return poos;
 }
@@ -166,7 +204,7 @@ const Chili& World::GetChiliConst() const
 	return chili;
 }
 
-const std::vector<Bullet>& World::GetBulletsConst() const
+const BulletStore& World::GetBulletsConst() const
 {
 	return bullets;
 }
@@ -5,6 +5,7 @@
 #include "Bullet.h"
 #include "Background.h"
 #include "Boundary.h"
+#include "SpatialGrid.h"
 #include "Sound.h"
 #include "Keyboard.h"
 #include "Mouse.h"
@@ -17,13 +18,37 @@ public:
 	World( const RectI& screenRect );
 	void HandleInput( Keyboard& kbd,Mouse& mouse );
 	void Update( float dt );
-	void Draw( Graphics& gfx ) const;
-	void SpawnBullet( Bullet bullet );
-	const std::vector<Poo>& GetPoosConst() const;
+	void Draw( RenderQueue& rq ) const;
+	// the scenery underlayer paints over every pixel of rect (no need to clear it first)
+	bool Covers( const RectI& rect ) const;
+	// most draws Draw can record in a frame (for RenderQueue::Reserve)
+	int GetMaxDrawCount() const;
+	void SpawnBullet( const Vec2& pos,const Vec2& dir );
+	const PooStore& GetPoosConst() const;
 	const Chili& GetChiliConst() const;
-	const std::vector<Bullet>& GetBulletsConst() const;
+	const BulletStore& GetBulletsConst() const;
 	const Boundary& GetBoundsConst() const;
 private:
+	// damages poos with the bullets that hit them and removes those bullets (and oob ones)
+	// targets are the live poos
+	void CollideBulletsWithPoos();
+private:
+	// all the poos there will ever be (they are all spawned at the start)
+	static constexpr int maxPoos = 12;
+	// boundary that characters must remain inside of
+	static constexpr float boundsLeft = 32.0f;
+	static constexpr float boundsRight = 768.0f;
+	static constexpr float boundsTop = 96.0f;
+	static constexpr float boundsBottom = 576.0f + 64.0f;
+	// chili fires at most one bullet a frame (one per click), and frames are vsynced to 60 hz
+	static constexpr float maxShotsPerSecond = 60.0f;
+	// a bullet flies straight until it leaves the boundary, and no straight line across
+	// it (grown by the bullet hitbox) is longer than its width + height
+	static constexpr float maxBulletLifetime =
+		(boundsRight - boundsLeft + 2.0f * BulletStore::hitbox_halfwidth +
+		boundsBottom - boundsTop + 2.0f * BulletStore::hitbox_halfheight) / BulletStore::speed;
+	// every bullet that can be in flight at once (faster displays recycle the oldest)
+	static constexpr int maxBullets = int( maxShotsPerSecond * maxBulletLifetime ) + 1;
 	std::mt19937 rng = std::mt19937( std::random_device{}() );
 	Sound bgm = Sound( L"Sounds\\come.mp3",Sound::LoopType::AutoFullSound );
 	// scenery underlayer
@@ -31,8 +56,14 @@ private:
 	// scenery overlayer
 	Background bg2;
 	Chili chili = Vec2{ 300.0f,300.0f };
-	std::vector<Poo> poos;
-	std::vector<Bullet> bullets;
-	// boundary that characters must remain inside of
-	Boundary bounds = RectF{ 32.0f,768.0f,96.0f,576.0f + 64.0f };
+	PooStore poos;
+	// bullet collision scratch (reserved up front so it doesn't allocate)
+	std::vector<Vec2> targetCenters;
+	std::vector<int> targetPoos;
+	SpatialGrid pooHitGrid;
+	// target index each bullet hit (number of targets if none)
+	std::vector<int> bulletHits;
+	std::vector<int> hitCounts;
+	BulletStore bullets;
+	Boundary bounds = RectF{ boundsLeft,boundsRight,boundsTop,boundsBottom };
 };
\ No newline at end of file
@@ -0,0 +1,146 @@
+// checks every BlitKernels tier the cpu supports against the scalar versions
+// (they all have to produce exactly the same output, in both source directions)
+#include "BlitKernels.h"
+#include "KernelRegistry.h"
+#include "Colors.h"
+#include <cstdio>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	int nFailures = 0;
+	const Color chroma = Colors::Magenta;
+
+	void Check( bool ok,SimdTier tier,const std::string& what )
+	{
+		if( !ok )
+		{
+			std::printf( "FAIL [%s] %s\n",KernelRegistry::GetTierName( tier ),what.c_str() );
+			nFailures++;
+		}
+	}
+
+	// premultiplied pixels (what AlphaBlend is fed) with runs of fully transparent,
+	// fully opaque and chroma keyed pixels mixed in, so the simd skip paths get hit
+	std::vector<Color> MakePixels()
+	{
+		std::mt19937 rng( 42u );
+		std::vector<Color> pixels;
+		while( pixels.size() < 8192u )
+		{
+			const unsigned int kind = rng() % 5u;
+			const int run = 1 + int( rng() % 40u );
+			for( int i = 0; i < run; i++ )
+			{
+				const unsigned int r = rng() & 0xFFu;
+				const unsigned int g = rng() & 0xFFu;
+				const unsigned int b = rng() & 0xFFu;
+				unsigned int a = rng() & 0xFFu;
+				if( kind == 0u )
+				{
+					pixels.push_back( chroma );
+					continue;
+				}
+				a = kind == 1u ? 0u : kind == 2u ? 255u : a;
+				pixels.push_back( Color( (unsigned char)a,(unsigned char)(r * a / 255u),
+					(unsigned char)(g * a / 255u),(unsigned char)(b * a / 255u) ) );
+			}
+		}
+		return pixels;
+	}
+
+	// runs op at every start offset 0..15 and length 0..199 of the pixels, walking the
+	// source forward and backward (so the vector loops see all alignments and tails),
+	// then once over a span long enough for the widest code paths
+	// dst starts out as a different part of the pixels, so blends have something to mix with
+	typedef std::function<void( const Color* pSrc,int srcStep,Color* pDst,int n )> Op;
+	std::vector<Color> RunOp( const std::vector<Color>& pixels,const Op& op )
+	{
+		std::vector<Color> out;
+		for( int srcStep : { 1,-1 } )
+		{
+			for( int offset = 0; offset < 16; offset++ )
+			{
+				for( int n = 0; n < 200; n++ )
+				{
+					// guard pixels on either side catch kernels writing out of range
+					std::vector<Color> dst( n + 2,Color( 0xDEADBEEFu ) );
+					std::copy( pixels.end() - n,pixels.end(),dst.begin() + 1 );
+					const Color* const pSrc = pixels.data() + offset + (srcStep == 1 ? 0 : n - 1);
+					op( pSrc,srcStep,dst.data() + 1,n );
+					out.insert( out.end(),dst.begin(),dst.end() );
+				}
+			}
+		}
+		const int nLong = (1 << 23) + 13;
+		std::vector<Color> src( nLong );
+		std::vector<Color> dst( nLong + 2,Color( 0xDEADBEEFu ) );
+		for( int i = 0; i < nLong; i++ )
+		{
+			src[i] = pixels[i % pixels.size()];
+			dst[i + 1] = pixels[(i * 7) % pixels.size()];
+		}
+		op( src.data(),1,dst.data() + 1,nLong );
+		out.insert( out.end(),dst.begin(),dst.end() );
+		return out;
+	}
+}
+
+int main()
+{
+	const std::vector<Color> pixels = MakePixels();
+	std::vector<std::pair<std::string,Op>> ops;
+	ops.emplace_back( "Chroma",[]( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		BlitKernels::Chroma( pSrc,srcStep,pDst,n,chroma );
+	} );
+	ops.emplace_back( "AlphaBlend",[]( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		BlitKernels::AlphaBlend( pSrc,srcStep,pDst,n );
+	} );
+	ops.emplace_back( "Copy",[]( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		BlitKernels::Copy( pSrc,srcStep,pDst,n );
+	} );
+	ops.emplace_back( "StreamCopy",[]( const Color* pSrc,int srcStep,Color* pDst,int n )
+	{
+		// forward only, so the backward runs copy the same pixels forward
+		BlitKernels::StreamCopy( srcStep == 1 ? pSrc : pSrc - (n - 1),pDst,n );
+	} );
+	ops.emplace_back( "Fill",[]( const Color* /*pSrc*/,int /*srcStep*/,Color* pDst,int n )
+	{
+		BlitKernels::Fill( pDst,n,Colors::Cyan );
+	} );
+
+	// reference results
+	KernelRegistry::SetTierLimit( SimdTier::Scalar );
+	std::vector<std::vector<Color>> expected;
+	for( auto& op : ops )
+	{
+		expected.push_back( RunOp( pixels,op.second ) );
+	}
+	for( int t = int( SimdTier::SSE2 ); t <= int( KernelRegistry::GetSupportedTier() ); t++ )
+	{
+		const SimdTier tier = SimdTier( t );
+		KernelRegistry::SetTierLimit( tier );
+		for( size_t i = 0; i < ops.size(); i++ )
+		{
+			const std::vector<Color> actual = RunOp( pixels,ops[i].second );
+			Check( actual.size() == expected[i].size() &&
+				std::equal( actual.begin(),actual.end(),expected[i].begin(),
+					[]( Color a,Color b ) { return a.dword == b.dword; } ),
+				tier,ops[i].first );
+		}
+		std::printf( "[%s] checked %d kernels\n",KernelRegistry::GetTierName( tier ),int( ops.size() ) );
+	}
+	if( nFailures != 0 )
+	{
+		std::printf( "%d failures\n",nFailures );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,146 @@
+// checks every ColorConvert kernel tier the cpu supports against the scalar versions
+// (they all have to produce exactly the same output)
+#include "ColorConvert.h"
+#include "KernelRegistry.h"
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	int nFailures = 0;
+
+	void Check( bool ok,SimdTier tier,const std::string& what )
+	{
+		if( !ok )
+		{
+			std::printf( "FAIL [%s] %s\n",KernelRegistry::GetTierName( tier ),what.c_str() );
+			nFailures++;
+		}
+	}
+
+	// every (alpha,channel) pair, then random pixels
+	std::vector<Color> MakePixels()
+	{
+		std::vector<Color> pixels;
+		for( unsigned int a = 0u; a < 256u; a++ )
+		{
+			for( unsigned int c = 0u; c < 256u; c++ )
+			{
+				pixels.push_back( Color( (unsigned char)a,(unsigned char)c,(unsigned char)(255u - c),(unsigned char)(c * 7u) ) );
+			}
+		}
+		std::mt19937 rng( 42u );
+		for( int i = 0; i < 4096; i++ )
+		{
+			pixels.push_back( Color( (unsigned int)rng() ) );
+		}
+		return pixels;
+	}
+
+	// runs op over every length 0..67 at every start offset 0..7 of the pixels (so the
+	// vector loops see all alignments and tail lengths), then over the whole lot
+	typedef std::function<void( const Color* pSrc,Color* pDst,int n )> Op;
+	std::vector<Color> RunOp( const std::vector<Color>& pixels,const Op& op )
+	{
+		std::vector<Color> out;
+		for( int offset = 0; offset < 8; offset++ )
+		{
+			for( int n = 0; n < 68; n++ )
+			{
+				// guard pixels on either side catch kernels writing out of range
+				std::vector<Color> dst( n + 2,Color( 0xDEADBEEFu ) );
+				op( pixels.data() + offset,dst.data() + 1,n );
+				out.insert( out.end(),dst.begin(),dst.end() );
+			}
+		}
+		std::vector<Color> dst( pixels.size() );
+		op( pixels.data(),dst.data(),int( pixels.size() ) );
+		out.insert( out.end(),dst.begin(),dst.end() );
+		return out;
+	}
+}
+
+int main()
+{
+	const std::vector<Color> pixels = MakePixels();
+	const int zero = ColorConvert::Order::Zero;
+	const ColorConvert::Order orders[] = {
+		{ 0,1,2,3 },
+		{ 2,1,0,3 },
+		{ 2,1,0,zero },
+		{ 3,2,1,0 },
+		{ zero,0,zero,1 }
+	};
+	std::vector<std::pair<std::string,Op>> ops;
+	ops.emplace_back( "Premultiply",[]( const Color* pSrc,Color* pDst,int n )
+	{
+		std::copy( pSrc,pSrc + n,pDst );
+		ColorConvert::Premultiply( pDst,n );
+	} );
+	ops.emplace_back( "Unpremultiply",[]( const Color* pSrc,Color* pDst,int n )
+	{
+		std::copy( pSrc,pSrc + n,pDst );
+		ColorConvert::Unpremultiply( pDst,n );
+	} );
+	for( int o = 0; o < int( sizeof( orders ) / sizeof( orders[0] ) ); o++ )
+	{
+		const auto order = orders[o];
+		ops.emplace_back( "Swizzle order " + std::to_string( o ),[order]( const Color* pSrc,Color* pDst,int n )
+		{
+			ColorConvert::Swizzle( pSrc,pDst,n,order );
+		} );
+		ops.emplace_back( "Swizzle in place order " + std::to_string( o ),[order]( const Color* pSrc,Color* pDst,int n )
+		{
+			std::copy( pSrc,pSrc + n,pDst );
+			ColorConvert::Swizzle( pDst,pDst,n,order );
+		} );
+		ops.emplace_back( "Swizzle unaligned order " + std::to_string( o ),[order]( const Color* pSrc,Color* pDst,int n )
+		{
+			// source one byte off the pixel grid
+			std::vector<unsigned char> bytes( n * 4 + 1 );
+			std::memcpy( bytes.data() + 1,pSrc,n * 4 );
+			ColorConvert::Swizzle( bytes.data() + 1,pDst,n,order );
+		} );
+	}
+	for( bool keepAlpha : { false,true } )
+	{
+		ops.emplace_back( std::string( "RgbaToBgrx keepAlpha " ) + (keepAlpha ? "true" : "false"),
+			[keepAlpha]( const Color* pSrc,Color* pDst,int n )
+		{
+			ColorConvert::RgbaToBgrx( reinterpret_cast<const unsigned char*>( pSrc ),pDst,n,keepAlpha );
+		} );
+	}
+
+	// reference results
+	KernelRegistry::SetTierLimit( SimdTier::Scalar );
+	std::vector<std::vector<Color>> expected;
+	for( auto& op : ops )
+	{
+		expected.push_back( RunOp( pixels,op.second ) );
+	}
+	for( int t = int( SimdTier::SSE2 ); t <= int( KernelRegistry::GetSupportedTier() ); t++ )
+	{
+		const SimdTier tier = SimdTier( t );
+		KernelRegistry::SetTierLimit( tier );
+		for( size_t i = 0; i < ops.size(); i++ )
+		{
+			const std::vector<Color> actual = RunOp( pixels,ops[i].second );
+			Check( actual.size() == expected[i].size() &&
+				std::equal( actual.begin(),actual.end(),expected[i].begin(),
+					[]( Color a,Color b ) { return a.dword == b.dword; } ),
+				tier,ops[i].first );
+		}
+		std::printf( "[%s] checked %d routines\n",KernelRegistry::GetTierName( tier ),int( ops.size() ) );
+	}
+	if( nFailures != 0 )
+	{
+		std::printf( "%d failures\n",nFailures );
+		return 1;
+	}
+	return 0;
+}
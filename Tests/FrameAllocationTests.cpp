@@ -0,0 +1,67 @@
+// runs whole headless frames of the game (logic, draw, render) with every poo spawned and
+// chili firing as fast as he can, and checks the heap isn't touched after the first frame
+// (run from the Engine directory, sprites are loaded from Images\)
+// built with CHILI_COUNT_ALLOCATIONS, so AllocationCounter counts in release builds too
+#include "AllocationCounter.h"
+#include "Graphics.h"
+#include "MemoryFrameTarget.h"
+#include "RenderQueue.h"
+#include "World.h"
+#include "Keyboard.h"
+#include "Mouse.h"
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+int main()
+{
+	static_assert( AllocationCounter::enabled,"the test needs the counting operator new" );
+	Graphics gfx( std::make_unique<MemoryFrameTarget>() );
+	// one band, so all the playback happens on this thread where the counter can see it
+	RenderQueue rq( 1 );
+	Keyboard kbd;
+	Mouse mouse;
+	const float dt = 1.0f / 60.0f;
+	// the poos are all dead a few seconds in, so the run is split into rounds, each
+	// with a fresh world that starts out with every poo
+	const int nRounds = 6;
+	const int nFramesPerRound = 600;
+	int nFramesAllocating = 0;
+	size_t nAllocations = 0u;
+	for( int round = 0; round < nRounds; round++ )
+	{
+		World world( gfx.GetScreenRect() );
+		rq.Reserve( world.GetMaxDrawCount() );
+		int nFramesWithPoos = 0;
+		for( int frame = 0; frame < nFramesPerRound; frame++ )
+		{
+			const size_t nAllocsBefore = AllocationCounter::GetCount();
+			gfx.BeginFrame( Colors::Black,world.Covers( gfx.GetScreenRect() ) );
+			world.HandleInput( kbd,mouse );
+			// one shot every 60 hz frame is chili's top rate (one bullet per click, one click
+			// per frame), sweeping around so bullets hit poos and fly out everywhere
+			const float angle = float( frame ) * 0.37f + float( round );
+			world.SpawnBullet( world.GetChiliConst().GetPos(),{ std::cos( angle ),std::sin( angle ) } );
+			world.Update( dt );
+			world.Draw( rq );
+			rq.Render( gfx );
+			gfx.EndFrame();
+			nFramesWithPoos += world.GetPoosConst().GetCount() != 0 ? 1 : 0;
+			// the first frame of the game runs before anything else, let it settle things
+			const size_t nFrameAllocs = AllocationCounter::GetCount() - nAllocsBefore;
+			if( !(round == 0 && frame == 0) && nFrameAllocs != 0u )
+			{
+				if( nFramesAllocating < 10 )
+				{
+					std::printf( "round %d frame %d: %d allocations\n",round,frame,int( nFrameAllocs ) );
+				}
+				nFramesAllocating++;
+				nAllocations += nFrameAllocs;
+			}
+		}
+		std::printf( "round %d: %d frames, poos alive for %d of them, %d bullets in flight at the end\n",
+			round,nFramesPerRound,nFramesWithPoos,world.GetBulletsConst().GetCount() );
+	}
+	std::printf( "%d allocations in %d frames\n",int( nAllocations ),nFramesAllocating );
+	return nFramesAllocating != 0 ? 1 : 0;
+}
@@ -0,0 +1,115 @@
+// checks that RenderQueue playback split into bands gives exactly the frame that
+// drawing the same sprites straight into Graphics does, for every band count
+// (run from the Engine directory, the sprites are loaded from Images\)
+#include "RenderQueue.h"
+#include "Graphics.h"
+#include "MemoryFrameTarget.h"
+#include "SpriteEffect.h"
+#include "CompiledSprite.h"
+#include "Surface.h"
+#include <cstdio>
+#include <memory>
+#include <random>
+
+namespace
+{
+	class Sprites
+	{
+	public:
+		Surface link = Surface( L"Images\\link90x90.bmp" );
+		Surface dice = Surface( L"Images\\pm_alphadice.png" );
+		CompiledSprite poo = CompiledSprite( Surface( L"Images\\poo.bmp" ),Colors::White );
+	};
+
+	// one frame of sprites scattered over and past the screen edges, mirrored or not,
+	// some with a clip rect of their own, through every kind of effect
+	// (one sort key, so the queue keeps submission order and both paths draw the same sequence)
+	template<typename Target>
+	void DrawScene( Target& target,const Sprites& sprites,unsigned int seed )
+	{
+		std::mt19937 rng( seed );
+		std::uniform_int_distribution<int> xd( -120,Graphics::ScreenWidth + 20 );
+		std::uniform_int_distribution<int> yd( -120,Graphics::ScreenHeight + 20 );
+		std::uniform_int_distribution<int> frame( 0,19 );
+		std::uniform_real_distribution<float> percent( 0.0f,1.0f );
+		target.DrawSprite( int( rng() % 64u ) - 32,int( rng() % 64u ) - 32,sprites.dice.GetRect(),
+			Graphics::GetScreenRect(),sprites.dice,SpriteEffect::Copy{},false );
+		for( int i = 0; i < 150; i++ )
+		{
+			const int x = xd( rng );
+			const int y = yd( rng );
+			const bool reversed = (rng() & 1u) != 0u;
+			const int f = frame( rng );
+			const RectI src = { (f % 5) * 90,(f % 5) * 90 + 90,(f / 5) * 90,(f / 5) * 90 + 90 };
+			RectI clip = Graphics::GetScreenRect();
+			if( rng() % 4u == 0u )
+			{
+				clip = RectI{ 100,700,50,450 };
+			}
+			switch( rng() % 8u )
+			{
+			case 0:
+				target.DrawSprite( x,y,src,clip,sprites.link,SpriteEffect::Chroma{ Colors::Magenta },reversed );
+				break;
+			case 1:
+				target.DrawSprite( x,y,src,clip,sprites.link,SpriteEffect::Ghost{ Colors::Magenta },reversed );
+				break;
+			case 2:
+				target.DrawSprite( x,y,src,clip,sprites.link,
+					SpriteEffect::Substitution{ Colors::Magenta,Colors::White },reversed );
+				break;
+			case 3:
+				target.DrawSprite( x,y,src,clip,sprites.link,
+					SpriteEffect::DissolveHalfTint{ Colors::Magenta,Colors::Red,percent( rng ) },reversed );
+				break;
+			case 4:
+				target.DrawSprite( x,y,src,clip,sprites.link,SpriteEffect::Copy{},reversed );
+				break;
+			case 5:
+				target.DrawSprite( x,y,RectI{ 200,400,100,300 },clip,sprites.dice,SpriteEffect::AlphaBlendBaked{},reversed );
+				break;
+			case 6:
+				target.DrawSprite( x,y,sprites.poo,SpriteEffect::Copy{},reversed );
+				break;
+			default:
+				target.DrawSprite( x,y,sprites.poo,
+					SpriteEffect::DissolveHalfTint{ Colors::White,Colors::Blue,percent( rng ) },reversed );
+				break;
+			}
+		}
+	}
+}
+
+int main()
+{
+	const Sprites sprites;
+	const int bandCounts[] = { 1,2,3,4,7,8,600 };
+	Graphics serial( std::make_unique<MemoryFrameTarget>() );
+	Graphics banded( std::make_unique<MemoryFrameTarget>() );
+	int nFailures = 0;
+	for( int nBands : bandCounts )
+	{
+		RenderQueue rq( nBands );
+		int nMismatches = 0;
+		for( unsigned int frame = 0u; frame < 50u; frame++ )
+		{
+			serial.BeginFrame();
+			DrawScene( serial,sprites,frame );
+			banded.BeginFrame();
+			DrawScene( rq,sprites,frame );
+			rq.Render( banded );
+			for( int y = 0; y < Graphics::ScreenHeight; y++ )
+			{
+				for( int x = 0; x < Graphics::ScreenWidth; x++ )
+				{
+					nMismatches += serial.GetPixel( x,y ) != banded.GetPixel( x,y ) ? 1 : 0;
+				}
+			}
+			serial.EndFrame();
+			banded.EndFrame();
+		}
+		std::printf( "%d band(s): %d mismatched pixels over 50 frames\n",rq.GetBandCount(),nMismatches );
+		nFailures += nMismatches != 0 ? 1 : 0;
+	}
+	return nFailures != 0 ? 1 : 0;
+}
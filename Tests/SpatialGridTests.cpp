@@ -0,0 +1,109 @@
+// checks SpatialGrid::FindFirstWithin against the loop poo avoidance used before the grid:
+// test every other poo in list order and take the first one closer than the radius
+#include "SpatialGrid.h"
+#include "Poo.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	int nFailures = 0;
+
+	int BruteForceFirstWithin( const std::vector<Vec2>& positions,int self,float radius )
+	{
+		for( int other = 0; other < int( positions.size() ); other++ )
+		{
+			if( other != self && (positions[self] - positions[other]).GetLengthSq() < radius * radius )
+			{
+				return other;
+			}
+		}
+		return -1;
+	}
+
+	// builds the grid the way PooStore::ProcessLogic does and compares every point
+	void Check( const std::string& name,const std::vector<Vec2>& positions )
+	{
+		const float radius = PooStore::avoidanceRadius;
+		SpatialGrid grid;
+		grid.Reserve( int( positions.size() ) );
+		grid.Build( positions.data(),int( positions.size() ),radius );
+		int nMismatches = 0;
+		int nAvoiding = 0;
+		for( int self = 0; self < int( positions.size() ); self++ )
+		{
+			const int expected = BruteForceFirstWithin( positions,self,radius );
+			nMismatches += grid.FindFirstWithin( positions.data(),self,radius ) != expected ? 1 : 0;
+			nAvoiding += expected >= 0 ? 1 : 0;
+		}
+		std::printf( "%-28s %6d points, %6d avoiding, %d mismatches\n",
+			name.c_str(),int( positions.size() ),nAvoiding,nMismatches );
+		nFailures += nMismatches != 0 ? 1 : 0;
+	}
+
+	// n points spread over a square sized for about one point per 30x30 px
+	// (the density the poos end up at when they crowd around chili)
+	std::vector<Vec2> Uniform( int n,unsigned int seed )
+	{
+		std::mt19937 rng( seed );
+		std::uniform_real_distribution<float> d( 0.0f,30.0f * std::sqrt( float( n ) ) );
+		std::vector<Vec2> positions;
+		for( int i = 0; i < n; i++ )
+		{
+			const float x = d( rng );
+			positions.push_back( { x,d( rng ) } );
+		}
+		return positions;
+	}
+}
+
+int main()
+{
+	for( int n : { 0,1,2,12,100,1000,5000 } )
+	{
+		Check( "uniform " + std::to_string( n ),Uniform( n,(unsigned int)n ) );
+	}
+
+	// everyone piled up on a few spots, stacked poos at exactly the same place
+	{
+		std::mt19937 rng( 7u );
+		std::vector<Vec2> positions;
+		for( int i = 0; i < 2000; i++ )
+		{
+			const float spot = float( rng() % 5u ) * 100.0f;
+			positions.push_back( { spot + float( rng() % 8u ),spot } );
+		}
+		Check( "clusters",positions );
+	}
+
+	// one straggler far off makes the grid grow its cells past the radius
+	{
+		std::vector<Vec2> positions = Uniform( 1000,99u );
+		positions.push_back( { 1.0e5f,-1.0e5f } );
+		positions.insert( positions.begin(),{ -3.0e4f,2.0e4f } );
+		Check( "stragglers",positions );
+	}
+
+	// pairs exactly on the radius (not within it) and just inside it, on cell edges
+	{
+		std::vector<Vec2> positions;
+		for( int i = 0; i < 50; i++ )
+		{
+			const float x = float( i ) * 20.0f;
+			positions.push_back( { x,0.0f } );
+			positions.push_back( { x,20.0f } );
+			positions.push_back( { x + 12.0f,35.99f } );
+		}
+		Check( "radius edges",positions );
+	}
+
+	if( nFailures != 0 )
+	{
+		std::printf( "%d failures\n",nFailures );
+		return 1;
+	}
+	return 0;
+}